@@ -1,6 +1,8 @@
 const { load, Gtk } = require('../');
 
 const GdkPixbuf = load('GdkPixbuf');
+const GLib = load('GLib');
+const Gio = load('Gio');
 
 const window = new Gtk.Window({
   type: Gtk.WindowType.TOPLEVEL,
@@ -33,9 +35,46 @@ describe('Arguments direction', () => {
       const pixbuf = new GdkPixbuf.Pixbuf();
       window.setIcon(pixbuf);
     });
+
+    test('typed arrays, array buffers and arrays of numbers', () => {
+      const bytes = new Uint8Array([104, 105]);
+      expect(GLib.base64Encode(bytes)).toEqual('aGk=');
+      expect(GLib.base64Encode(bytes.buffer)).toEqual('aGk=');
+      expect(GLib.base64Encode(Buffer.from('hi'))).toEqual('aGk=');
+      expect(GLib.base64Encode([104, 105])).toEqual('aGk=');
+      expect(GLib.base64Encode(bytes.subarray(1))).toEqual('aQ==');
+    });
+
+    test('typed arrays of the wrong element type are rejected', () => {
+      expect(() => GLib.base64Encode(new Float64Array(2))).toThrow();
+    });
+
+    test('arrays of strings', () => {
+      expect(GLib.strvLength(['a', 'b', 'c'])).toEqual(3);
+    });
   });
 
   describe('out', () => {
+    test('integers', () => {
+      window.resize(200, 100);
+      const [width, height] = window.getSize();
+      expect(typeof width).toEqual('number');
+      expect(typeof height).toEqual('number');
+    });
+
+    test('arrays with a hidden length', () => {
+      const bytes = GLib.base64Decode('aGk=');
+      expect(bytes).toBeInstanceOf(Uint8Array);
+      expect(Array.from(bytes)).toEqual([104, 105]);
+    });
+
+    test('caller allocated arrays sized by an in length', () => {
+      const stream = Gio.MemoryInputStream.newFromData(new Uint8Array([104, 105, 33]), null);
+      const [bytesRead, buffer] = stream.read(2, null); // read(buffer, count, cancellable)
+      expect(bytesRead).toEqual(2);
+      expect(Array.from(buffer)).toEqual([104, 105]);
+    });
+
     // test('out arguments', () => {
     //   window.setTitle("Lancelot");
     //   expect(window.getProperty("title")).toEqual("Lancelot");
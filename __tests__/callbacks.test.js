@@ -1,4 +1,5 @@
-const { load } = require('../');
+const { load, Gtk } = require('../');
+const { getStats } = require('../src/addon');
 
 const GLib = load('GLib');
 const Gio = load('Gio');
@@ -15,4 +16,35 @@ describe('callbacks', () => {
     task.returnBoolean(true);
     loop.run();
   });
+
+  test('callbacks can return values to native code', () => {
+    const loop = new GLib.MainLoop(null, false);
+    const leaked = getStats().ffiTrampolinesLeaked;
+    let calls = 0;
+    GLib.idleAdd(0, () => {
+      calls += 1;
+      if (calls === 3) {
+        loop.quit();
+        return false;
+      }
+      return true;
+    });
+    loop.run();
+    expect(calls).toEqual(3);
+    expect(getStats().ffiTrampolinesLeaked).toEqual(leaked); // released by it's destroy notify
+  });
+
+  test('call scoped callbacks reuse their trampoline', () => {
+    const box = new Gtk.Box();
+    box.add(new Gtk.Label());
+    box.add(new Gtk.Label());
+    const children = [];
+    box.foreach((child) => children.push(child));
+    const { ffiTrampolinesPrepared: prepared, ffiTrampolinesLeaked: leaked } = getStats();
+    box.foreach((child) => children.push(child));
+    box.foreach((child) => children.push(child));
+    expect(getStats().ffiTrampolinesPrepared).toEqual(prepared);
+    expect(getStats().ffiTrampolinesLeaked).toEqual(leaked);
+    expect(children.length).toEqual(6);
+  });
 });
@@ -1,8 +1,9 @@
-const { load, Gtk } = require('../');
+const { load, configure, Gtk } = require('../');
 
 const GObject = load('GObject');
 const GdkPixbuf = load('GdkPixbuf');
 const GIRepository = load('GIRepository');
+const GLib = load('GLib');
 
 const pixbuf = new GdkPixbuf.Pixbuf();
 
@@ -19,6 +20,37 @@ describe('functions', () => {
       button.setLabel('my label'); // object method
       expect(button.label).toEqual('my label');
     });
+
+    test('object methods are built once and shared by every instance', () => {
+      const first = new Gtk.Button();
+      const second = new Gtk.Button();
+      expect(typeof first.setLabel).toEqual('function');
+      expect(first.setLabel).toBe(second.setLabel);
+      expect(first.getParent).toBe(new Gtk.Label().getParent); // inherited from GtkWidget
+    });
+
+    test('assigning to a method only replaces it on that instance', () => {
+      const first = new Gtk.Button();
+      const second = new Gtk.Button();
+      const replacement = () => 'replaced';
+      first.setImagePosition = replacement;
+      expect(first.setImagePosition).toBe(replacement);
+      expect(second.setImagePosition).not.toBe(replacement);
+      expect(typeof second.setImagePosition).toEqual('function');
+      second.setImagePosition(Gtk.PositionType.TOP);
+      expect(second.getImagePosition()).toEqual(Gtk.PositionType.TOP);
+    });
+
+    test('string arguments keep non-ascii and long strings intact', () => {
+      const button = new Gtk.Button();
+      const unicode = 'ünïcødé ラベル 🐧';
+      button.setLabel(unicode);
+      expect(button.label).toEqual(unicode);
+
+      const long = 'x'.repeat(10000);
+      button.setLabel(long);
+      expect(button.label).toEqual(long);
+    });
   });
 
   describe('functions can return values', () => {
@@ -81,6 +113,60 @@ describe('functions', () => {
       });
     });
 
+    test('functions can return: lists', () => {
+      const box = new Gtk.Box();
+      const label = new Gtk.Label();
+      const button = new Gtk.Button();
+      box.add(label);
+      box.add(button);
+      const children = box.getChildren();
+      expect(Array.isArray(children)).toBe(true);
+      expect(children.length).toEqual(2);
+      expect(children[0]).toBe(label);
+      expect(children[1]).toBe(button);
+    });
+
+    test('lists can be returned as lazy iterators', () => {
+      const box = new Gtk.Box();
+      const label = new Gtk.Label();
+      box.add(label);
+      configure({ lazyLists: true });
+      try {
+        const children = box.getChildren();
+        expect(Array.isArray(children)).toBe(false);
+        expect([...children]).toEqual([label]);
+        expect(children.next().done).toBe(true);
+      } finally {
+        configure({ lazyLists: false });
+      }
+    });
+
+    test('64 bit integers are returned as numbers by default', () => {
+      expect(typeof GLib.getRealTime()).toEqual('number');
+      const [max] = GLib.asciiStrtoull('18446744073709551615', 10);
+      expect(typeof max).toEqual('number');
+    });
+
+    if (typeof BigInt === 'function') {
+      test('64 bit integers that need it are returned as BigInts when enabled', () => {
+        configure({ bigint: true });
+        try {
+          expect(typeof GLib.getRealTime()).toEqual('number');
+          const [max] = GLib.asciiStrtoull('18446744073709551615', 10);
+          expect(max).toEqual(BigInt('18446744073709551615'));
+          expect(GLib.asciiStrtoll('-9007199254740993', 10)[0]).toEqual(
+            BigInt('-9007199254740993')
+          );
+        } finally {
+          configure({ bigint: false });
+        }
+      });
+
+      test('BigInts can be passed as 64 bit integers', () => {
+        expect(() => GLib.usleep(BigInt(0))).not.toThrow();
+      });
+    }
+
     test('functions with out arguments should return an array', () => {
       const button = new Gtk.Button();
       const result = button.getPreferredSize();
@@ -0,0 +1,68 @@
+/**
+ * Calls functions with out, inout and array length arguments through both the
+ * cached libffi invoker (the default) and the legacy g_function_info_invoke()
+ * path. The legacy path can only be selected when the native module is loaded
+ * so each path runs in it's own child process (like bench/invoke.js).
+ */
+const { execFileSync } = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+function callFunctions(contentsPath) {
+  const { load, Gtk } = require('../');
+  const GLib = load('GLib');
+
+  const window = new Gtk.Window();
+  window.setDefaultSize(200, 100);
+
+  const entry = new Gtk.Entry();
+  entry.setText('ac');
+
+  const [parsed, argv] = GLib.shellParseArgv('echo "a b" c');
+  const [read, contents] = GLib.fileGetContents(contentsPath);
+  return {
+    defaultSize: window.getDefaultSize(), // 2 out arguments
+    shellParseArgv: [parsed, argv], // out array with a hidden out length
+    fileGetContents: [read, Array.from(contents)], // out byte array with a hidden length
+    base64Decode: Array.from(GLib.base64Decode('aGk=')), // returned array with a hidden length
+    insertText: entry.insertText('b', -1, 1), // inout position
+    text: entry.getText(),
+  };
+}
+
+function runChild(env, contentsPath) {
+  const output = execFileSync(process.execPath, [__filename, '--child', contentsPath], {
+    env: Object.assign({}, process.env, env),
+  });
+  return JSON.parse(output.toString());
+}
+
+if (process.argv.includes('--child')) {
+  const contentsPath = process.argv[process.argv.indexOf('--child') + 1];
+  process.stdout.write(JSON.stringify(callFunctions(contentsPath)));
+  process.exit(0); // the GLib loop would keep the child alive
+} else {
+  describe('invoke paths', () => {
+    const contentsPath = path.join(os.tmpdir(), `node-gir-invoke-${process.pid}`);
+    const expected = {
+      defaultSize: [200, 100],
+      shellParseArgv: [true, ['echo', 'a b', 'c']],
+      fileGetContents: [true, [104, 105]],
+      base64Decode: [104, 105],
+      insertText: 2,
+      text: 'abc',
+    };
+
+    beforeAll(() => fs.writeFileSync(contentsPath, 'hi'));
+    afterAll(() => fs.unlinkSync(contentsPath));
+
+    test('the cached invoker passes and returns out, inout and array length arguments', () => {
+      expect(runChild({}, contentsPath)).toEqual(expected);
+    });
+
+    test('the legacy invoke path returns the same values', () => {
+      expect(runChild({ NODE_GIR_LEGACY_INVOKE: '1' }, contentsPath)).toEqual(expected);
+    });
+  });
+}
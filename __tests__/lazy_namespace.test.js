@@ -0,0 +1,27 @@
+const { load } = require('../');
+
+describe('lazy namespaces', () => {
+  const Gio = load('Gio', '2.0', { lazy: true });
+
+  test('exports are listed before they are built', () => {
+    expect(Object.keys(Gio)).toContain('Menu');
+    expect(Object.keys(Gio)).toContain('FileType');
+  });
+
+  test('exports are built on first access and cached', () => {
+    const { Menu } = Gio;
+    expect(typeof Menu).toEqual('function');
+    expect(Gio.Menu).toBe(Menu);
+  });
+
+  test('lazy exports work the same as eager exports', () => {
+    expect(Gio.FileType.DIRECTORY).toEqual(load('Gio', '2.0').FileType.DIRECTORY);
+    expect(typeof Gio.contentTypeGuess).toEqual('function');
+  });
+
+  test('exports can be replaced before they are built', () => {
+    const replacement = {};
+    Gio.Cancellable = replacement;
+    expect(Gio.Cancellable).toBe(replacement);
+  });
+});
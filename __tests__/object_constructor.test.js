@@ -1,4 +1,11 @@
-const { Gtk } = require('../');
+const v8 = require('v8');
+const vm = require('vm');
+const { load, Gtk } = require('../');
+
+const Gio = load('Gio');
+
+v8.setFlagsFromString('--expose-gc');
+const gc = vm.runInNewContext('gc');
 
 describe('Object constructor', () => {
   describe('with "new" operator', () => {
@@ -13,3 +20,46 @@ describe('Object constructor', () => {
     });
   });
 });
+
+describe('Object wrappers', () => {
+  it('returns the same wrapper for the same native object', () => {
+    const box = new Gtk.Box();
+    const label = new Gtk.Label();
+    box.add(label);
+    expect(label.getParent()).toBe(box);
+    expect(label.getParent()).toBe(label.getParent());
+  });
+
+  it('releases objects returned with transfer full when the wrapper is collected', () => {
+    const base = Gio.MemoryInputStream.new();
+    (() => {
+      // the buffered stream closes it's base stream when it's finalized
+      Gio.BufferedInputStream.new(base);
+    })();
+    gc();
+    expect(base.isClosed()).toBe(true);
+  });
+
+  it('releases objects whose signal handlers capture their own wrapper', () => {
+    const base = Gio.MemoryInputStream.new();
+    (() => {
+      const stream = Gio.BufferedInputStream.new(base);
+      stream.connect('notify', () => stream.getBufferSize());
+    })();
+    gc();
+    expect(base.isClosed()).toBe(true);
+  });
+
+  it('keeps the wrapper (and it\'s signal handlers) while native code holds the object', () => {
+    const box = new Gtk.Box();
+    let notified = 0;
+    (() => {
+      const label = new Gtk.Label();
+      label.connect('notify::label', () => { notified += 1; });
+      box.add(label);
+    })();
+    gc();
+    box.getChildren()[0].label = 'still connected';
+    expect(notified).toEqual(1);
+  });
+});
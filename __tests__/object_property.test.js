@@ -46,6 +46,12 @@ describe('Gtk.Object', () => {
         expect(win['default-height']).not.toEqual(0);
         expect(win['default-height']).not.toEqual(-1);
       });
+
+      it('can use underscores instead of dashes', () => {
+        win.default_height = 2;
+        expect(win.default_height).toEqual(2);
+        expect(win['default-height']).toEqual(2);
+      });
     });
 
     // TODO: see issue https://github.com/Place1/node-gir/issues/2
@@ -72,3 +78,47 @@ describe('Gtk.Object', () => {
     });
   });
 });
+
+describe('wrapper properties', () => {
+  it('are accessors on the prototype', () => {
+    const label = new Gtk.Label({ label: 'text' });
+    expect(Object.getOwnPropertyNames(label)).not.toContain('label');
+    expect(label.label).toEqual('text');
+  });
+
+  it('plain JS properties stay on the instance', () => {
+    const first = new Gtk.Label();
+    const second = new Gtk.Label();
+    first.myCustomData = 42;
+    expect(first.myCustomData).toEqual(42);
+    expect(second.myCustomData).toBeUndefined();
+  });
+});
+
+describe('bulk properties', () => {
+  it('getProperties reads many properties at once', () => {
+    const label = new Gtk.Label({ label: 'text', selectable: true });
+    expect(label.getProperties(['label', 'selectable'])).toEqual({
+      label: 'text',
+      selectable: true,
+    });
+  });
+
+  it('setProperties writes many properties at once', () => {
+    const label = new Gtk.Label();
+    label.setProperties({ label: 'batched', 'max-width-chars': 12 });
+    expect(label.label).toEqual('batched');
+    expect(label['max-width-chars']).toEqual(12);
+  });
+
+  it('unset string properties are null', () => {
+    const label = new Gtk.Label();
+    expect(label.tooltip_text).toBeNull();
+  });
+
+  it('throws for unknown properties', () => {
+    const label = new Gtk.Label();
+    expect(() => label.getProperties(['not-a-property'])).toThrow();
+    expect(() => label.setProperties({ notAProperty: 1 })).toThrow();
+  });
+});
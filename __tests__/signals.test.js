@@ -1,4 +1,5 @@
 const { Gtk } = require('../');
+const { getStats } = require('../src/addon');
 
 describe('signals', () => {
   test('connect() returns a number', () => {
@@ -48,4 +49,126 @@ describe('signals', () => {
     });
     entry.setText('dummy text');
   });
+
+  test('signal params are converted to JS and the callback\'s result is returned to native code', () => {
+    const scale = Gtk.Scale.newWithRange(Gtk.Orientation.HORIZONTAL, 0, 10, 1);
+    scale.setDrawValue(true);
+    scale.setValue(5);
+    const calls = [];
+    scale.connect('format-value', (instance, value) => {
+      calls.push([instance, value]);
+      return `value: ${value}`;
+    });
+    expect(scale.getLayout().getText()).toEqual('value: 5');
+    expect(calls.length).not.toBeLessThan(1);
+    expect(calls[0][0]).toBe(scale);
+    expect(calls[0][1]).toEqual(5);
+  });
+
+  test('instances of a subclass of the signal\'s type use the planned converter', () => {
+    const scale = Gtk.Scale.newWithRange(Gtk.Orientation.HORIZONTAL, 0, 10, 1);
+    const instances = [];
+    scale.connect('value-changed', (instance) => instances.push(instance)); // defined on GtkRange
+    const unplanned = getStats().signalUnplannedConversions;
+    scale.setValue(5);
+    expect(instances.length).toEqual(1);
+    expect(instances[0]).toBe(scale);
+    expect(getStats().signalUnplannedConversions).toEqual(unplanned);
+  });
+
+  test('object params are converted to their wrapper', () => {
+    const box = new Gtk.Box();
+    const label = new Gtk.Label();
+    const added = [];
+    box.connect('add', (instance, widget) => added.push([instance, widget]));
+    box.add(label);
+    expect(added).toEqual([[box, label]]);
+    expect(added[0][1]).toBe(label);
+  });
+
+  test('coalesced signals deliver only the latest emission', () => {
+    const button = new Gtk.Button();
+    let calls = 0;
+    button.connect('clicked', () => { calls += 1; }, { coalesce: 'frame' });
+    button.clicked();
+    button.clicked();
+    button.clicked();
+    expect(calls).toEqual(0);
+    while (Gtk.eventsPending()) {
+      Gtk.mainIteration();
+    }
+    expect(calls).toEqual(1);
+  });
+
+  test('signals that return a value can\'t be coalesced', () => {
+    const window = new Gtk.Window();
+    expect(() => window.connect('delete-event', () => false, { coalesce: 16 })).toThrow();
+    expect(() => window.connect('show', () => undefined, { coalesce: 'sometimes' })).toThrow();
+  });
+
+  test('filtered signals only deliver emissions with a matching detail', () => {
+    const label = new Gtk.Label();
+    const notified = [];
+    label.connect('notify', (self, pspec) => notified.push(pspec), {
+      filter: { detail: ['label', 'max_width_chars'] },
+    });
+    label.label = 'filtered';
+    label.selectable = true;
+    label['max-width-chars'] = 3;
+    expect(notified.length).toEqual(2);
+  });
+
+  test('filtered signals only deliver emissions with matching params', () => {
+    const notebook = new Gtk.Notebook();
+    notebook.appendPage(new Gtk.Label(), null);
+    notebook.appendPage(new Gtk.Label(), null);
+    notebook.appendPage(new Gtk.Label(), null);
+    notebook.showAll();
+    const pages = [];
+    notebook.connect('switch-page', (self, page, pageNumber) => pages.push(pageNumber), {
+      filter: { params: { 2: [0, 2] } },
+    });
+    notebook.setCurrentPage(1);
+    notebook.setCurrentPage(2);
+    notebook.setCurrentPage(0);
+    expect(pages).toEqual([2, 0]);
+  });
+
+  test('only integer like params can be filtered', () => {
+    const notebook = new Gtk.Notebook();
+    expect(() => notebook.connect('switch-page', () => undefined, { filter: { params: { 1: 0 } } })).toThrow();
+  });
+
+  test('connectOnce() handlers are only called for the first emission', () => {
+    const button = new Gtk.Button();
+    let calls = 0;
+    button.connectOnce('clicked', () => { calls += 1; });
+    button.clicked();
+    button.clicked();
+    expect(calls).toEqual(1);
+    expect(button.disconnectAll()).toEqual(0);
+  });
+
+  test('connectAfter() handlers run after handlers connected with connect()', () => {
+    const button = new Gtk.Button();
+    const order = [];
+    button.connectAfter('clicked', () => order.push('after'));
+    button.connect('clicked', () => order.push('before'));
+    button.clicked();
+    expect(order).toEqual(['before', 'after']);
+  });
+
+  test('disconnectAll() disconnects a group\'s handlers or every handler', () => {
+    const button = new Gtk.Button();
+    const calls = [];
+    button.connect('clicked', () => calls.push('a'), { group: 'view' });
+    button.connect('clicked', () => calls.push('b'), { group: 'view' });
+    button.connect('clicked', () => calls.push('c'));
+    expect(button.disconnectAll('view')).toEqual(2);
+    button.clicked();
+    expect(calls).toEqual(['c']);
+    expect(button.disconnectAll()).toEqual(1);
+    button.clicked();
+    expect(calls).toEqual(['c']);
+  });
 });
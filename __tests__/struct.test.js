@@ -70,4 +70,38 @@ describe('struct', () => {
     expect(structA instanceof structB.constructor).toBe(true);
     expect(structB instanceof structA.constructor).toBe(true);
   });
+
+  test('fields can be written and read back', () => {
+    const rectangle = new Gdk.Rectangle();
+    rectangle.x = -3;
+    rectangle.width = 2147483647;
+    expect(rectangle.x).toEqual(-3);
+    expect(rectangle.width).toEqual(2147483647);
+
+    const color = new Gdk.RGBA({ red: 0.25, green: 0.5, blue: 1, alpha: 0.75 });
+    expect(color.red).toEqual(0.25);
+    expect(color.green).toEqual(0.5);
+    expect(color.blue).toEqual(1);
+    expect(color.alpha).toEqual(0.75);
+  });
+
+  test('struct memory can be viewed as an ArrayBuffer', () => {
+    const layout = Gdk.Rectangle.getLayout();
+    expect(layout.fields.width).toEqual({ offset: 8, size: 4, type: 'Int32' });
+
+    const rectangle = new Gdk.Rectangle({ width: 10 });
+    const buffer = rectangle.asArrayBuffer();
+    expect(buffer.byteLength).toEqual(layout.size);
+
+    const view = new DataView(buffer);
+    const { offset } = layout.fields.width;
+    expect(view.getInt32(offset, true)).toEqual(10);
+    view.setInt32(offset, 42, true);
+    expect(rectangle.width).toEqual(42);
+  });
+
+  test('a struct always returns the same ArrayBuffer', () => {
+    const rectangle = new Gdk.Rectangle({ width: 10 });
+    expect(rectangle.asArrayBuffer()).toBe(rectangle.asArrayBuffer());
+  });
 });
@@ -0,0 +1,31 @@
+/**
+ * Counts how often Args has to fall back to the heap for it's argument
+ * lists and scratch arena. For the common call shapes this should be 0
+ * allocations per call.
+ *
+ *   $ node bench/allocations.js
+ */
+const { load } = require('../');
+const { getStats, resetStats } = require('../src/addon');
+
+const GLib = load('GLib');
+const iterations = 100000;
+
+const calls = [
+  ['GLib.getMonotonicTime()', () => GLib.getMonotonicTime()],
+  ['GLib.pathIsAbsolute(string)', () => GLib.pathIsAbsolute('/usr/lib')],
+  ['GLib.asciiDigitValue(number)', () => GLib.asciiDigitValue(55)],
+];
+
+calls.forEach(([name, fn]) => {
+  resetStats();
+  for (let i = 0; i < iterations; i++) {
+    fn();
+  }
+  const stats = getStats();
+  const argsPerCall = stats.argsHeapAllocations / stats.nativeCalls;
+  const arenaPerCall = stats.arenaHeapAllocations / stats.nativeCalls;
+  console.log(
+    `${name.padEnd(40)} ${argsPerCall.toFixed(3)} args, ${arenaPerCall.toFixed(3)} arena heap allocations/call`
+  );
+});
@@ -0,0 +1,32 @@
+/**
+ * Measures steady-state call throughput for a representative set of
+ * functions, methods and property accesses.
+ *
+ *   $ node bench/calls.js
+ */
+const { Gtk, GLib } = require('../');
+const { measure, formatResult } = require('./harness');
+
+const label = new Gtk.Label({ label: 'benchmark' });
+const box = new Gtk.Box();
+box.add(label);
+
+const benchmarks = [
+  ['GLib.getMonotonicTime()', () => GLib.getMonotonicTime()],
+  ['GLib.pathIsAbsolute(string)', () => GLib.pathIsAbsolute('/usr/lib')],
+  ['GLib.pathGetBasename(string)', () => GLib.pathGetBasename('/usr/lib')],
+  ['label.setText(string)', () => label.setText('some text')],
+  ['label.getText()', () => label.getText()],
+  ['label.getParent()', () => label.getParent()],
+  ['label.label (property get)', () => label.label],
+  [
+    'label.label = string (property set)',
+    () => {
+      label.label = 'some text';
+    },
+  ],
+];
+
+benchmarks.forEach(([name, fn]) => {
+  console.log(formatResult(measure(name, fn, 100000)));
+});
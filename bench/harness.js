@@ -0,0 +1,36 @@
+/**
+ * A tiny benchmark harness. Each benchmark is a function that is called
+ * in a tight loop, first to warm up (so V8 has a chance to optimise the
+ * JS side of the call) and then for the measured iterations.
+ */
+function measure(name, fn, iterations = 200000) {
+  const warmup = Math.min(iterations / 10, 10000);
+  for (let i = 0; i < warmup; i++) {
+    fn();
+  }
+
+  const start = process.hrtime();
+  for (let i = 0; i < iterations; i++) {
+    fn();
+  }
+  const [seconds, nanoseconds] = process.hrtime(start);
+  const elapsedNs = seconds * 1e9 + nanoseconds;
+
+  return {
+    name,
+    iterations,
+    nsPerOp: elapsedNs / iterations,
+    opsPerSec: Math.round(iterations / (elapsedNs / 1e9)),
+  };
+}
+
+function formatResult(result) {
+  const nsPerOp = result.nsPerOp.toFixed(1).padStart(10);
+  const opsPerSec = result.opsPerSec.toLocaleString().padStart(14);
+  return `${result.name.padEnd(40)} ${nsPerOp} ns/op ${opsPerSec} ops/s`;
+}
+
+module.exports = {
+  measure,
+  formatResult,
+};
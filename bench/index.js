@@ -0,0 +1,17 @@
+/**
+ * Runs every benchmark in the suite, each in it's own process so they can't
+ * affect each other.
+ *
+ *   $ npm run bench
+ */
+const { execFileSync } = require('child_process');
+const path = require('path');
+
+const suites = ['load.js', 'calls.js', 'invoke.js', 'allocations.js'];
+
+suites.forEach(suite => {
+  console.log(`\n# ${suite}\n`);
+  execFileSync(process.execPath, [path.join(__dirname, suite)], {
+    stdio: 'inherit',
+  });
+});
@@ -0,0 +1,47 @@
+/**
+ * Compares the cached libffi invoker (the default) against the legacy
+ * g_function_info_invoke() path. The legacy path can only be selected when
+ * the native module is loaded, so each path is measured in it's own child
+ * process.
+ *
+ *   $ node bench/invoke.js
+ */
+const { execFileSync } = require('child_process');
+const { measure, formatResult } = require('./harness');
+
+function runBenchmarks() {
+  const { load } = require('../');
+  const GLib = load('GLib');
+
+  return [
+    measure('GLib.getMonotonicTime()', () => GLib.getMonotonicTime()),
+    measure('GLib.pathIsAbsolute(string)', () => GLib.pathIsAbsolute('/usr/lib')),
+    measure('GLib.pathGetBasename(string)', () => GLib.pathGetBasename('/usr/lib')),
+    measure('GLib.asciiDigitValue(number)', () => GLib.asciiDigitValue(55)),
+  ];
+}
+
+function runChild(env) {
+  const output = execFileSync(process.execPath, [__filename, '--child'], {
+    env: Object.assign({}, process.env, env),
+  });
+  return JSON.parse(output.toString());
+}
+
+if (process.argv.includes('--child')) {
+  process.stdout.write(JSON.stringify(runBenchmarks()));
+} else {
+  const legacy = runChild({ NODE_GIR_LEGACY_INVOKE: '1' });
+  const cached = runChild({});
+
+  console.log('g_function_info_invoke (legacy)');
+  legacy.forEach(result => console.log(formatResult(result)));
+  console.log('\ncached ffi invoker');
+  cached.forEach(result => console.log(formatResult(result)));
+
+  console.log('\nspeedup');
+  cached.forEach((result, i) => {
+    const speedup = legacy[i].nsPerOp / result.nsPerOp;
+    console.log(`${result.name.padEnd(40)} ${speedup.toFixed(2)}x`);
+  });
+}
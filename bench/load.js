@@ -0,0 +1,76 @@
+/**
+ * Measures how long load() takes for a few namespaces, broken down by phase
+ * (see the loadTimings stat). A cold load is the first load in a fresh
+ * process so it includes reading the typelib and building every template.
+ * A warm load is a repeated load in the same process.
+ *
+ *   $ node bench/load.js
+ */
+const { execFileSync } = require('child_process');
+
+const namespaces = [['GLib', '2.0'], ['Gio', '2.0'], ['Gtk', '3.0']];
+const warmIterations = 10;
+const phases = ['require', 'objects', 'functions', 'structs', 'enums'];
+
+function timeLoad(namespace, version, options) {
+  const { load, getStats, resetStats } = require('../src/addon');
+  resetStats();
+  const start = process.hrtime();
+  load(namespace, version, options);
+  const [seconds, nanoseconds] = process.hrtime(start);
+  return {
+    totalUs: seconds * 1e6 + nanoseconds / 1e3,
+    phasesUs: getStats().loadTimings,
+  };
+}
+
+function runChild(namespace, version, lazy) {
+  const args = [__filename, '--child', namespace, version];
+  if (lazy) {
+    args.push('--lazy');
+  }
+  const output = execFileSync(process.execPath, args);
+  return JSON.parse(output.toString());
+}
+
+function formatTiming(name, timing) {
+  const total = `${(timing.totalUs / 1000).toFixed(2)}ms`.padStart(10);
+  const breakdown = phases
+    .map(phase => `${phase} ${(timing.phasesUs[phase] / 1000).toFixed(2)}ms`)
+    .join(', ');
+  return `${name.padEnd(24)} ${total}  (${breakdown})`;
+}
+
+function averageTimings(timings) {
+  const average = { totalUs: 0, phasesUs: {} };
+  phases.forEach(phase => {
+    average.phasesUs[phase] = 0;
+  });
+  timings.forEach(timing => {
+    average.totalUs += timing.totalUs / timings.length;
+    phases.forEach(phase => {
+      average.phasesUs[phase] += timing.phasesUs[phase] / timings.length;
+    });
+  });
+  return average;
+}
+
+if (process.argv.includes('--child')) {
+  const [namespace, version] = process.argv.slice(3);
+  const options = { lazy: process.argv.includes('--lazy') };
+  const cold = timeLoad(namespace, version, options);
+  const warm = [];
+  for (let i = 0; i < warmIterations; i++) {
+    warm.push(timeLoad(namespace, version, options));
+  }
+  process.stdout.write(JSON.stringify({ cold, warm: averageTimings(warm) }));
+} else {
+  [false, true].forEach(lazy => {
+    console.log(lazy ? '\nlazy exports' : 'eager exports');
+    namespaces.forEach(([namespace, version]) => {
+      const { cold, warm } = runChild(namespace, version, lazy);
+      console.log(formatTiming(`${namespace} (cold)`, cold));
+      console.log(formatTiming(`${namespace} (warm)`, warm));
+    });
+  });
+}
@@ -5,13 +5,18 @@
             'sources': [
                 'src/main.cpp',
                 'src/util.cpp',
+                'src/stats.cpp',
+                'src/config.cpp',
+                'src/int64.cpp',
                 'src/namespace_loader.cpp',
                 'src/arguments.cpp',
+                'src/call_plan.cpp',
                 'src/values.cpp',
                 'src/types/object.cpp',
                 'src/types/struct.cpp',
                 'src/types/function.cpp',
                 'src/types/enum.cpp',
+                'src/types/list_iterator.cpp',
                 'src/loop.cpp',
                 'src/closure.cpp'
             ],
@@ -5,7 +5,11 @@
 #include <sstream>
 #include <vector>
 #include "closure.h"
+#include "config.h"
 #include "exceptions.h"
+#include "int64.h"
+#include "stats.h"
+#include "types/list_iterator.h"
 #include "types/object.h"
 #include "types/struct.h"
 
@@ -13,8 +17,12 @@ using namespace v8;
 
 namespace gir {
 
-Args::Args(GICallableInfo *callable_info) : callable_info(callable_info) {
-    g_base_info_ref(callable_info); // because we keep a reference to the info we need to tell glib
+Args::Args(CallPlan &plan) : plan(plan) {
+    // every argument already knows which slot it goes into (including the
+    // instance argument of methods, which always goes into in[0]) so we can
+    // size the argument lists up front.
+    this->in.resize(plan.n_in_args);
+    this->out.resize(plan.n_out_args);
 }
 
 /**
@@ -26,147 +34,638 @@ Args::Args(GICallableInfo *callable_info) : callable_info(callable_info) {
  * @param js_callback_info is a JS function call info object
  */
 void Args::load_js_arguments(const Nan::FunctionCallbackInfo<v8::Value> &js_callback_info) {
-    // get the number of arguments the native function requires
-    guint8 gi_argc = g_callable_info_get_n_args(this->callable_info.get());
-
-    // for every expected native argument, we'll take a given JS argument and
-    // convert it into a GIArgument, adding it to the in/out args array depending
-    // on it's direction.
-    for (guint8 i = 0; i < gi_argc; i++) {
-        GIArgInfo argument_info;
-        g_callable_info_load_arg(this->callable_info.get(), i, &argument_info);
-        GIDirection argument_direction = g_arg_info_get_direction(&argument_info);
-
-        if (argument_direction == GI_DIRECTION_IN) {
-            GIArgument argument = Args::arg_to_g_type(argument_info, js_callback_info[i]);
-            this->in.push_back(argument);
+    // hidden array length arguments aren't passed in from JS. They're set up first
+    // so that converting an array can fill in it's length (wherever it is
+    // in the argument list).
+    for (ArgPlan &argument : this->plan.args) {
+        if (argument.is_array_length) {
+            this->load_array_length_argument(argument);
+        }
+        // a callback's user_data and destroy notify stay null unless the
+        // callback is given (see callback_to_g_type)
+        if (argument.is_callback_data) {
+            this->in[argument.in_index].v_pointer = nullptr;
+        }
+    }
+
+    // for every other native argument, we'll take a given JS argument and
+    // convert it into a GIArgument, putting it into the in/out args slot that
+    // the call plan assigned to it. All of the type information we need was
+    // already loaded from the typelib when the call plan was built.
+    for (ArgPlan &argument : this->plan.args) {
+        if (argument.is_array_length || argument.is_callback_data) {
+            continue;
         }
 
-        if (argument_direction == GI_DIRECTION_OUT) {
-            GIArgument argument = this->get_out_argument_value(argument_info);
-            this->out.push_back(argument);
+        if (argument.direction == GI_DIRECTION_IN) {
+            this->in[argument.in_index] = this->arg_to_g_type(argument, js_callback_info[argument.js_index]);
         }
 
-        if (argument_direction == GI_DIRECTION_INOUT) {
-            GIArgument argument = Args::arg_to_g_type(argument_info, js_callback_info[i]);
-            this->in.push_back(argument);
+        if (argument.direction == GI_DIRECTION_INOUT) {
+            // INOUT arguments are passed as a pointer to their value which the
+            // native function can replace.
+            GIArgument *value = this->alloc_argument_value();
+            *value = this->arg_to_g_type(argument, js_callback_info[argument.js_index]);
+            this->in[argument.in_index].v_pointer = value;
+            this->out[argument.out_index].v_pointer = value;
+        }
+    }
 
-            // TODO: is it correct to handle INOUT arguments like IN args?
-            // do we need to handle callee (native) allocates or empty input
-            // GIArguments like we do with OUT args? i'm just assuming this is how it
-            // should work (treating it like an IN arg). Hopfully I can find some
-            // examples to make some test cases asserting the correct behaviour
-            this->out.push_back(argument);
+    // OUT arguments are set up once every IN argument has been converted
+    // because a caller-allocates array is sized by it's IN length argument.
+    for (ArgPlan &argument : this->plan.args) {
+        if (argument.direction == GI_DIRECTION_OUT && !argument.is_array_length) {
+            this->out[argument.out_index] = this->get_out_argument_value(argument);
         }
     }
 }
 
+/**
+ * returns the value the native function reads for an IN or INOUT argument.
+ */
+GIArgument *Args::in_value(ArgPlan &argument) {
+    if (argument.direction == GI_DIRECTION_INOUT) {
+        return static_cast<GIArgument *>(this->in[argument.in_index].v_pointer);
+    }
+    return &this->in[argument.in_index];
+}
+
+/**
+ * returns the value the native function wrote to an OUT or INOUT argument.
+ * Caller-allocates arguments are the memory the native function filled in.
+ */
+GIArgument *Args::out_value(ArgPlan &argument) {
+    if (argument.direction == GI_DIRECTION_OUT && argument.caller_allocates) {
+        return &this->out[argument.out_index];
+    }
+    return static_cast<GIArgument *>(this->out[argument.out_index].v_pointer);
+}
+
+/**
+ * returns the length of an array from the argument at the given native index,
+ * or -1 if there's no such argument.
+ */
+int Args::array_length(int length_index) {
+    if (length_index < 0 || length_index >= (int)this->plan.args.size()) {
+        return -1;
+    }
+    ArgPlan &length_argument = this->plan.args[length_index];
+    GIArgument *value = length_argument.direction == GI_DIRECTION_IN ? this->in_value(length_argument)
+                                                                     : this->out_value(length_argument);
+    return (int)Args::integer_from_g_type(value, length_argument.type_tag);
+}
+
+GIArgument *Args::alloc_argument_value() {
+    return static_cast<GIArgument *>(this->arena.alloc0(sizeof(GIArgument)));
+}
+
+void Args::load_array_length_argument(ArgPlan &argument) {
+    if (argument.direction == GI_DIRECTION_IN) {
+        this->in[argument.in_index].v_uint64 = 0;
+    } else if (argument.direction == GI_DIRECTION_OUT) {
+        this->out[argument.out_index] = this->get_out_argument_value(argument);
+    } else {
+        GIArgument *value = this->alloc_argument_value();
+        this->in[argument.in_index].v_pointer = value;
+        this->out[argument.out_index].v_pointer = value;
+    }
+}
+
+/**
+ * sets the (hidden) length argument of an array that's passed in from JS.
+ */
+void Args::set_array_length(ArgPlan &array_argument, gsize length) {
+    if (array_argument.array_length_index < 0) {
+        return;
+    }
+    ArgPlan &length_argument = this->plan.args[array_argument.array_length_index];
+    if (length_argument.direction == GI_DIRECTION_OUT) {
+        return; // the native function tells us the length
+    }
+    Args::integer_to_g_type(this->in_value(length_argument), length_argument.type_tag, length);
+}
+
+gint64 Args::integer_from_g_type(GIArgument *value, GITypeTag type_tag) {
+    switch (type_tag) {
+        case GI_TYPE_TAG_INT8:
+            return value->v_int8;
+        case GI_TYPE_TAG_UINT8:
+            return value->v_uint8;
+        case GI_TYPE_TAG_INT16:
+            return value->v_int16;
+        case GI_TYPE_TAG_UINT16:
+            return value->v_uint16;
+        case GI_TYPE_TAG_INT32:
+            return value->v_int32;
+        case GI_TYPE_TAG_UINT32:
+            return value->v_uint32;
+        case GI_TYPE_TAG_INT64:
+            return value->v_int64;
+        case GI_TYPE_TAG_UINT64:
+            return value->v_uint64;
+        default:
+            stringstream message;
+            message << "array length of type '" << g_type_tag_to_string(type_tag) << "' is unsupported";
+            throw UnsupportedGIType(message.str());
+    }
+}
+
+void Args::integer_to_g_type(GIArgument *value, GITypeTag type_tag, gint64 integer) {
+    switch (type_tag) {
+        case GI_TYPE_TAG_INT8:
+            value->v_int8 = integer;
+            break;
+        case GI_TYPE_TAG_UINT8:
+            value->v_uint8 = integer;
+            break;
+        case GI_TYPE_TAG_INT16:
+            value->v_int16 = integer;
+            break;
+        case GI_TYPE_TAG_UINT16:
+            value->v_uint16 = integer;
+            break;
+        case GI_TYPE_TAG_INT32:
+            value->v_int32 = integer;
+            break;
+        case GI_TYPE_TAG_UINT32:
+            value->v_uint32 = integer;
+            break;
+        case GI_TYPE_TAG_INT64:
+            value->v_int64 = integer;
+            break;
+        case GI_TYPE_TAG_UINT64:
+            value->v_uint64 = integer;
+            break;
+        default:
+            stringstream message;
+            message << "array length of type '" << g_type_tag_to_string(type_tag) << "' is unsupported";
+            throw UnsupportedGIType(message.str());
+    }
+}
+
 /**
  * This function loads the context (i.e. this value of `this`) into the native call arguments.
  * By convention, the context value (a GIRObject in JS or a GObject in native) is put at the
- * start (position 0) of the function call's "in" arguments.
+ * start (position 0) of the function call's "in" arguments. The call plan reserves
+ * that slot for methods.
  */
 void Args::load_context(GObject *this_object) {
-    GIArgument this_object_argument = {
-        .v_pointer = this_object,
-    };
-    this->in.insert(this->in.begin(), this_object_argument);
+    this->in[0].v_pointer = this_object;
 }
 
-GIArgument Args::get_out_argument_value(GIArgInfo &argument_info) {
-    GITypeInfo argument_type_info;
-    g_arg_info_load_type(&argument_info, &argument_type_info);
-    if (g_arg_info_is_caller_allocates(&argument_info)) {
-        GITypeTag arg_type_tag = g_type_info_get_tag(&argument_type_info);
+GIArgument Args::get_out_argument_value(ArgPlan &argument) {
+    if (argument.caller_allocates && argument.type_tag == GI_TYPE_TAG_ARRAY) {
+        return this->alloc_out_array(argument);
+    }
+    if (argument.caller_allocates) {
         // If the caller is responsible for allocating the out arguments memeory
-        // then we'll have to look up the argument's type infomation and allocate
-        // a slice of memory for the GIArgument's .v_pointer (native function will
-        // fill it up)
-        if (arg_type_tag == GI_TYPE_TAG_INTERFACE) {
-            GIRInfoUniquePtr argument_interface_info = GIRInfoUniquePtr(g_type_info_get_interface(&argument_type_info));
-            GIInfoType argument_interface_type = g_base_info_get_type(argument_interface_info.get());
-            gsize argument_size;
-
-            if (argument_interface_type == GI_INFO_TYPE_STRUCT) {
-                argument_size = g_struct_info_get_size((GIStructInfo *)argument_interface_info.get());
-            } else if (argument_interface_type == GI_INFO_TYPE_UNION) {
-                argument_size = g_union_info_get_size((GIUnionInfo *)argument_interface_info.get());
-            } else {
-                stringstream message;
-                message << "type \"" << g_type_tag_to_string(arg_type_tag) << "\" for out caller-allocates";
+        // then we'll have to allocate a slice of memory for the GIArgument's
+        // .v_pointer (native function will fill it up). The size of the slice
+        // was worked out from the argument's struct or union info when the
+        // call plan was built.
+        if (argument.caller_allocates_size == 0) {
+            stringstream message;
+            message << "type \"" << g_type_tag_to_string(argument.type_tag) << "\" for out caller-allocates";
+            if (argument.type_tag == GI_TYPE_TAG_INTERFACE) {
                 message << " Expected a struct or union.";
-                throw UnsupportedGIType(message.str());
             }
-
-            GIArgument argument;
-            // FIXME: who deallocates?
-            // I imagine the original function caller (in JS land) will need
-            // to use the structure that the native function puts into this
-            // slice of memory, meaning we can't deallocate when Args is destroyed.
-            // Perhaps we should research into GJS and PyGObject to understand
-            // the problem of "out arguments with caller allocation" better.
-            // Some thoughts:
-            // 1. if the data is **copied** into a gir object/struct when passed back
-            //    to JS then we can safely implement a custom deleter for Args.out
-            //    that cleans this up.
-            // 2. if the pointer to the data is passed to a gir object/struct when
-            //    passed back to JS then that JS object should own it and be
-            //    responsible for cleaning it up.
-            // * both choices have caveats so it's worth understanding the
-            // implications
-            //   of each, or other options to solve this leak!
-            // * from reading GJS code, it seems like they copy the data before
-            // passing
-            // * to JS meaning option 1.
-            argument.v_pointer = g_slice_alloc0(argument_size);
-            return argument;
-        } else {
-            stringstream message;
-            message << "type \"" << g_type_tag_to_string(arg_type_tag) << "\" for out caller-allocates";
             throw UnsupportedGIType(message.str());
         }
+
+        // the native function only fills the memory in, so it's ours to free.
+        // it's allocated in the arena because the value is copied into a JS
+        // object (see GIRStruct::from_existing) before Args is destroyed.
+        GIArgument native_argument;
+        native_argument.v_pointer = this->arena.alloc0(argument.caller_allocates_size);
+        return native_argument;
     }
-    // else, if we're not responsible for allocation then we can just return an
-    // empty GIArgument with a NULL .v_pointer (native call will set it with a
-    // memory location)
-    GIArgument argument = {.v_pointer = nullptr};
-    return argument;
+    // else, the native function writes the value to the address we pass it
+    // so we give it somewhere (zeroed) to write to.
+    GIArgument native_argument;
+    native_argument.v_pointer = this->alloc_argument_value();
+    return native_argument;
 }
 
-GIArgument Args::arg_to_g_type(GIArgInfo &argument_info, Local<Value> js_value) {
-    GITypeInfo argument_type_info;
-    g_arg_info_load_type(&argument_info, &argument_type_info);
-    GITypeTag argument_type_tag = g_type_info_get_tag(&argument_type_info);
-
+GIArgument Args::arg_to_g_type(ArgPlan &argument, Local<Value> js_value) {
     if (js_value->IsNullOrUndefined()) {
-        if (g_arg_info_may_be_null(&argument_info) || argument_type_tag == GI_TYPE_TAG_VOID) {
+        if (argument.may_be_null || argument.type_tag == GI_TYPE_TAG_VOID) {
             GIArgument argument_value;
             argument_value.v_pointer = nullptr;
             argument_value.v_string = nullptr;
             return argument_value;
         }
         stringstream message;
-        message << "Argument '" << g_base_info_get_name(&argument_info) << "' may not be null or undefined";
+        message << "Argument '" << argument.name << "' may not be null or undefined";
         throw JSArgumentTypeError(message.str());
     }
 
     try {
-        return Args::type_to_g_type(argument_type_info, js_value);
+        switch (argument.type_tag) {
+            case GI_TYPE_TAG_UTF8:
+            case GI_TYPE_TAG_FILENAME:
+                return this->string_to_g_type(argument.transfer, js_value);
+
+            case GI_TYPE_TAG_ARRAY:
+                return this->array_to_g_type(argument, js_value);
+
+            case GI_TYPE_TAG_GLIST:
+            case GI_TYPE_TAG_GSLIST:
+                return this->list_to_g_type(argument, js_value);
+
+            case GI_TYPE_TAG_INTERFACE:
+                if (argument.interface_g_type == G_TYPE_VALUE) {
+                    return this->g_value_to_g_type(argument, js_value);
+                }
+                if (argument.interface_type == GI_INFO_TYPE_CALLBACK) {
+                    return this->callback_to_g_type(argument, js_value);
+                }
+                return Args::interface_to_g_type(argument.interface_info.get(),
+                                                 argument.interface_type,
+                                                 argument.interface_g_type,
+                                                 js_value);
+
+            default:
+                return Args::tag_to_g_type(argument.type_tag, js_value);
+        }
     } catch (JSArgumentTypeError &error) {
         // we want to nicely format all type errors so we'll catch them and rethrow
         // using a nice message
         Nan::Utf8String js_type_name(js_value->TypeOf(Isolate::GetCurrent()));
         stringstream message;
-        message << "Expected type '" << g_type_tag_to_string(argument_type_tag);
-        message << "' for Argument '" << g_base_info_get_name(&argument_info);
+        message << "Expected type '" << g_type_tag_to_string(argument.type_tag);
+        message << "' for Argument '" << argument.name;
         message << "' but got type '" << *js_type_name << "'";
         throw JSArgumentTypeError(message.str());
     }
 }
 
+/**
+ * Converts a JS string to a native string argument. The string is encoded
+ * straight into it's destination rather than going through a Nan::Utf8String
+ * so each argument is only copied once. Unless the native function takes
+ * ownership of the string, the destination is the arena (which means short
+ * strings don't touch the heap at all) and it's freed when the call is finished.
+ */
+GIArgument Args::string_to_g_type(GITransfer transfer, Local<Value> js_value) {
+    if (!js_value->IsString()) {
+        throw JSArgumentTypeError();
+    }
+
+    Local<String> js_string = Local<String>::Cast(js_value);
+    int length = js_string->Utf8Length();
+    char *buffer;
+    if (transfer == GI_TRANSFER_NOTHING) {
+        buffer = static_cast<char *>(this->arena.alloc(length + 1));
+    } else {
+        buffer = static_cast<char *>(g_malloc(length + 1));
+    }
+    js_string->WriteUtf8(buffer, length, nullptr, String::NO_NULL_TERMINATION | String::REPLACE_INVALID_UTF8);
+    buffer[length] = '\0';
+
+    GIArgument argument_value;
+    argument_value.v_string = buffer;
+    return argument_value;
+}
+
+/**
+ * Converts a JS value to a GValue argument. Unless the native function takes
+ * ownership of the GValue, it lives in the arena and is unset when the call
+ * is finished.
+ */
+GIArgument Args::g_value_to_g_type(ArgPlan &argument, Local<Value> js_value) {
+    GValue gvalue = GIRValue::to_g_value(js_value, G_TYPE_VALUE);
+    GIArgument argument_value;
+    if (argument.transfer == GI_TRANSFER_NOTHING) {
+        GValue *arena_gvalue = static_cast<GValue *>(this->arena.alloc(sizeof(GValue)));
+        *arena_gvalue = gvalue;
+        this->arena.defer((ScratchArena::Cleanup)g_value_unset, arena_gvalue);
+        argument_value.v_pointer = arena_gvalue;
+    } else {
+        argument_value.v_pointer = g_boxed_copy(G_TYPE_VALUE, &gvalue);
+        g_value_unset(&gvalue);
+    }
+    return argument_value;
+}
+
+/**
+ * Converts a JS value to a C array. For arrays of numbers, TypedArrays (of the
+ * matching element type), DataViews and ArrayBuffers are passed to the native
+ * function without copying unless the native function takes ownership of the
+ * array or it needs a zero terminator. Plain JS arrays are converted element by
+ * element. If the array has a length argument it's set from the JS value.
+ */
+GIArgument Args::array_to_g_type(ArgPlan &argument, Local<Value> js_value) {
+    if (argument.array_type != GI_ARRAY_TYPE_C) {
+        return Args::type_to_g_type(argument.type_info, js_value);
+    }
+    if (argument.array_element_is_pointer) {
+        return this->pointer_array_to_g_type(argument, js_value);
+    }
+    gsize element_size = Args::numeric_element_size(argument.array_element_tag);
+    if (element_size == 0) {
+        return Args::type_to_g_type(argument.type_info, js_value);
+    }
+
+    GIArgument argument_value;
+    gsize terminator_size = argument.array_zero_terminated ? element_size : 0;
+
+    if (js_value->IsArray()) {
+        Local<Array> js_array = Local<Array>::Cast(js_value);
+        guint32 length = js_array->Length();
+        char *native_array = (char *)this->allocate_array(argument, length * element_size + terminator_size);
+        for (guint32 i = 0; i < length; i++) {
+            // every member of GIArgument starts at the beginning of the union
+            GIArgument element = Args::tag_to_g_type(argument.array_element_tag, js_array->Get(i));
+            memcpy(native_array + i * element_size, &element, element_size);
+        }
+        memset(native_array + length * element_size, 0, terminator_size);
+        this->set_array_length(argument, length);
+        argument_value.v_pointer = native_array;
+        return argument_value;
+    }
+
+    char *data;
+    gsize byte_length;
+    if (js_value->IsArrayBufferView() &&
+        (js_value->IsDataView() || Args::typed_array_matches(js_value, argument.array_element_tag))) {
+        Local<ArrayBufferView> view = Local<ArrayBufferView>::Cast(js_value);
+        data = (char *)view->Buffer()->GetContents().Data() + view->ByteOffset();
+        byte_length = view->ByteLength();
+    } else if (js_value->IsArrayBuffer()) {
+        Local<ArrayBuffer> buffer = Local<ArrayBuffer>::Cast(js_value);
+        data = (char *)buffer->GetContents().Data();
+        byte_length = buffer->ByteLength();
+    } else {
+        throw JSArgumentTypeError();
+    }
+    if (byte_length % element_size != 0) {
+        throw JSArgumentTypeError("the array's byte length must be a multiple of it's element size");
+    }
+
+    if (argument.transfer == GI_TRANSFER_NOTHING && terminator_size == 0) {
+        // the native function only borrows the array for the duration of the call
+        argument_value.v_pointer = data;
+    } else {
+        char *native_array = (char *)this->allocate_array(argument, byte_length + terminator_size);
+        memcpy(native_array, data, byte_length);
+        memset(native_array + byte_length, 0, terminator_size);
+        argument_value.v_pointer = native_array;
+    }
+    this->set_array_length(argument, byte_length / element_size);
+    return argument_value;
+}
+
+/**
+ * Converts a JS array to a C array of pointers (such as strings or objects).
+ */
+GIArgument Args::pointer_array_to_g_type(ArgPlan &argument, Local<Value> js_value) {
+    if (!js_value->IsArray()) {
+        throw JSArgumentTypeError();
+    }
+
+    // the elements only belong to the native function if it takes ownership
+    // of everything, otherwise (like the array itself) they're freed after the call.
+    GITransfer element_transfer = argument.transfer == GI_TRANSFER_EVERYTHING ? GI_TRANSFER_EVERYTHING
+                                                                                : GI_TRANSFER_NOTHING;
+    Local<Array> js_array = Local<Array>::Cast(js_value);
+    guint32 length = js_array->Length();
+    gsize terminator_size = argument.array_zero_terminated ? 1 : 0;
+    gpointer *native_array = (gpointer *)this->allocate_array(argument, (length + terminator_size) * sizeof(gpointer));
+    for (guint32 i = 0; i < length; i++) {
+        native_array[i] = this->pointer_element_to_g_type(argument.array_element_type_info.get(),
+                                                          element_transfer,
+                                                          js_array->Get(i));
+    }
+    if (terminator_size > 0) {
+        native_array[length] = nullptr;
+    }
+    this->set_array_length(argument, length);
+
+    GIArgument argument_value;
+    argument_value.v_pointer = native_array;
+    return argument_value;
+}
+
+/**
+ * Converts a JS array to a GList or GSList. Unless the native function takes
+ * ownership of the list it's freed when the call is finished.
+ */
+GIArgument Args::list_to_g_type(ArgPlan &argument, Local<Value> js_value) {
+    if (!js_value->IsArray()) {
+        throw JSArgumentTypeError();
+    }
+
+    auto element_type_info = GIRInfoUniquePtr(g_type_info_get_param_type(&argument.type_info, 0));
+    GITransfer element_transfer = argument.transfer == GI_TRANSFER_EVERYTHING ? GI_TRANSFER_EVERYTHING
+                                                                                : GI_TRANSFER_NOTHING;
+    Local<Array> js_array = Local<Array>::Cast(js_value);
+    bool is_slist = argument.type_tag == GI_TYPE_TAG_GSLIST;
+    gpointer list = nullptr;
+
+    // prepending (from the end of the JS array) keeps building the list O(n)
+    for (guint32 i = js_array->Length(); i > 0; i--) {
+        gpointer element = this->pointer_element_to_g_type(element_type_info.get(),
+                                                           element_transfer,
+                                                           js_array->Get(i - 1));
+        if (is_slist) {
+            list = g_slist_prepend((GSList *)list, element);
+        } else {
+            list = g_list_prepend((GList *)list, element);
+        }
+    }
+
+    if (argument.transfer == GI_TRANSFER_NOTHING) {
+        this->arena.defer(is_slist ? (ScratchArena::Cleanup)g_slist_free : (ScratchArena::Cleanup)g_list_free, list);
+    }
+
+    GIArgument argument_value;
+    argument_value.v_pointer = list;
+    return argument_value;
+}
+
+/**
+ * Converts a JS value to an element of a native array or list. Only pointer
+ * types (strings, objects and structs) are supported.
+ */
+gpointer Args::pointer_element_to_g_type(GITypeInfo *element_type_info,
+                                         GITransfer element_transfer,
+                                         Local<Value> js_element) {
+    GITypeTag element_tag = g_type_info_get_tag(element_type_info);
+    switch (element_tag) {
+        case GI_TYPE_TAG_UTF8:
+        case GI_TYPE_TAG_FILENAME:
+            return this->string_to_g_type(element_transfer, js_element).v_pointer;
+        case GI_TYPE_TAG_INTERFACE:
+            return Args::type_to_g_type(*element_type_info, js_element).v_pointer;
+        default:
+            stringstream message;
+            message << "arrays and lists of '" << g_type_tag_to_string(element_tag) << "' are unsupported";
+            throw UnsupportedGIType(message.str());
+    }
+}
+
+/**
+ * allocates the (zeroed) memory for a caller-allocates OUT array. It's sized
+ * from the array's fixed size or it's IN length argument, which JS passed in.
+ */
+GIArgument Args::alloc_out_array(ArgPlan &argument) {
+    gint64 length = argument.array_fixed_size;
+    if (length < 0 && argument.array_length_index >= 0 &&
+        this->plan.args[argument.array_length_index].direction == GI_DIRECTION_IN) {
+        length = this->array_length(argument.array_length_index);
+    }
+    gsize element_size = argument.array_element_is_pointer ? sizeof(gpointer)
+                                                           : Args::numeric_element_size(argument.array_element_tag);
+    if (argument.array_type != GI_ARRAY_TYPE_C || length < 0 || element_size == 0) {
+        stringstream message;
+        message << "caller-allocates array argument '" << argument.name << "' has no size we can allocate";
+        throw UnsupportedGIType(message.str());
+    }
+
+    // one extra element so zero terminated arrays always have their terminator
+    GIArgument native_argument;
+    native_argument.v_pointer = this->arena.alloc0((length + 1) * element_size);
+    return native_argument;
+}
+
+/**
+ * allocates memory for an array argument. The arena owns it unless the native
+ * function takes ownership of the array.
+ */
+void *Args::allocate_array(ArgPlan &argument, gsize byte_length) {
+    if (argument.transfer == GI_TRANSFER_NOTHING) {
+        return this->arena.alloc(byte_length);
+    }
+    return g_malloc(byte_length);
+}
+
+/**
+ * returns the size of an element of a C array of numbers, or 0 if elements
+ * of the given type can't be converted in bulk.
+ */
+gsize Args::numeric_element_size(GITypeTag element_tag) {
+    switch (element_tag) {
+        case GI_TYPE_TAG_INT8:
+        case GI_TYPE_TAG_UINT8:
+            return 1;
+        case GI_TYPE_TAG_INT16:
+        case GI_TYPE_TAG_UINT16:
+            return 2;
+        case GI_TYPE_TAG_INT32:
+        case GI_TYPE_TAG_UINT32:
+        case GI_TYPE_TAG_FLOAT:
+            return 4;
+        case GI_TYPE_TAG_INT64:
+        case GI_TYPE_TAG_UINT64:
+        case GI_TYPE_TAG_DOUBLE:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * returns true if js_value is a TypedArray whose elements have the same type
+ * as the native array's elements. Uint8Arrays (including node Buffers) are
+ * accepted for signed bytes too.
+ */
+bool Args::typed_array_matches(Local<Value> js_value, GITypeTag element_tag) {
+    switch (element_tag) {
+        case GI_TYPE_TAG_INT8:
+            return js_value->IsInt8Array() || js_value->IsUint8Array();
+        case GI_TYPE_TAG_UINT8:
+            return js_value->IsUint8Array() || js_value->IsUint8ClampedArray();
+        case GI_TYPE_TAG_INT16:
+            return js_value->IsInt16Array();
+        case GI_TYPE_TAG_UINT16:
+            return js_value->IsUint16Array();
+        case GI_TYPE_TAG_INT32:
+            return js_value->IsInt32Array();
+        case GI_TYPE_TAG_UINT32:
+            return js_value->IsUint32Array();
+        case GI_TYPE_TAG_FLOAT:
+            return js_value->IsFloat32Array();
+        case GI_TYPE_TAG_DOUBLE:
+            return js_value->IsFloat64Array();
+#if NODE_GIR_HAVE_BIGINT
+        case GI_TYPE_TAG_INT64:
+            return js_value->IsBigInt64Array();
+        case GI_TYPE_TAG_UINT64:
+            return js_value->IsBigUint64Array();
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * copies a native array of numbers into a new TypedArray of the matching type.
+ * 64 bit integers are copied into a BigInt64Array (or BigUint64Array) if the
+ * bigint option is set, otherwise they're converted to a regular JS array of
+ * Numbers because there's no TypedArray that holds them.
+ */
+Local<Value> Args::numeric_array_to_js(gpointer native_array, GITypeTag element_tag, gsize length) {
+    gsize byte_length = length * Args::numeric_element_size(element_tag);
+
+    if ((element_tag == GI_TYPE_TAG_INT64 || element_tag == GI_TYPE_TAG_UINT64) && !Config::bigint) {
+        Local<Array> js_array = Nan::New<Array>(length);
+        for (gsize i = 0; i < length; i++) {
+            Local<Value> element = element_tag == GI_TYPE_TAG_INT64 ? Int64::from_int64(((gint64 *)native_array)[i])
+                                                                    : Int64::from_uint64(((guint64 *)native_array)[i]);
+            js_array->Set(i, element);
+        }
+        return js_array;
+    }
+
+    Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), byte_length);
+    if (byte_length > 0) {
+        memcpy(buffer->GetContents().Data(), native_array, byte_length);
+    }
+    switch (element_tag) {
+        case GI_TYPE_TAG_INT8:
+            return Int8Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_UINT8:
+            return Uint8Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_INT16:
+            return Int16Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_UINT16:
+            return Uint16Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_INT32:
+            return Int32Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_UINT32:
+            return Uint32Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_FLOAT:
+            return Float32Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_DOUBLE:
+            return Float64Array::New(buffer, 0, length);
+#if NODE_GIR_HAVE_BIGINT
+        case GI_TYPE_TAG_INT64:
+            return BigInt64Array::New(buffer, 0, length);
+        case GI_TYPE_TAG_UINT64:
+            return BigUint64Array::New(buffer, 0, length);
+#endif
+        default:
+            return buffer;
+    }
+}
+
 GIArgument Args::type_to_g_type(GITypeInfo &argument_type_info, Local<Value> js_value) {
     GITypeTag argument_type_tag = g_type_info_get_tag(&argument_type_info);
 
+    if (argument_type_tag == GI_TYPE_TAG_INTERFACE) {
+        auto interface_info = GIRInfoUniquePtr(g_type_info_get_interface(&argument_type_info));
+        GIInfoType interface_type = g_base_info_get_type(interface_info.get());
+        GType interface_g_type = G_TYPE_NONE;
+        if (GI_IS_REGISTERED_TYPE_INFO(interface_info.get())) {
+            interface_g_type = g_registered_type_info_get_g_type(interface_info.get());
+        }
+        return Args::interface_to_g_type(interface_info.get(), interface_type, interface_g_type, js_value);
+    }
+
+    return Args::tag_to_g_type(argument_type_tag, js_value);
+}
+
+GIArgument Args::tag_to_g_type(GITypeTag argument_type_tag, Local<Value> js_value) {
     // if the arg type is a GTYPE (which is an integer)
     // then we want to pretend it's a GI_TYPE_TAG_INTX
     // where x is the sizeof the GTYPE. This helper function
@@ -216,11 +715,11 @@ GIArgument Args::type_to_g_type(GITypeInfo &argument_type_info, Local<Value> js_
             break;
 
         case GI_TYPE_TAG_INT64:
-            argument_value.v_int64 = js_value->IntegerValue();
+            argument_value.v_int64 = Int64::to_int64(js_value);
             break;
 
         case GI_TYPE_TAG_UINT64:
-            argument_value.v_uint64 = js_value->IntegerValue();
+            argument_value.v_uint64 = Int64::to_uint64(js_value);
             break;
 
         case GI_TYPE_TAG_FLOAT:
@@ -236,79 +735,135 @@ GIArgument Args::type_to_g_type(GITypeInfo &argument_type_info, Local<Value> js_
             if (!js_value->IsString()) {
                 throw JSArgumentTypeError();
             } else {
+                // the caller owns the copy. Args converts function call strings
+                // itself (see Args::string_to_g_type) so this is only used for
+                // things like struct fields that need to keep the string.
                 Nan::Utf8String js_string(js_value->ToString());
-                // FIXME: memory leak as we never g_free(.v_string)
-                // ideally the memory would be freed when the GIArgument
-                // was destroyed. Perhaps we need to use a unique_ptr
-                // with a custom deleter?
-                // I think it's clear that the memory needs to be owned by
-                // the GIArgument (or value ToGType returns) because
-                // we can't expect callers to know they are responsible
-                // for deallocation, and we can't expect to borrow the
-                // memory (if we don't copy the string then tests start
-                // failing with corrupt memory rather than the original strings).
-                argument_value.v_string = strdup(*js_string);
+                argument_value.v_string = g_strdup(*js_string);
             }
             break;
 
-        case GI_TYPE_TAG_INTERFACE: {
-            auto interface_info = GIRInfoUniquePtr(g_type_info_get_interface(&argument_type_info));
-            GIInfoType interface_type = g_base_info_get_type(interface_info.get());
+        default:
+            stringstream message;
+            message << "argument type \"" << g_type_tag_to_string(argument_type_tag) << "\" is unsupported.";
+            throw UnsupportedGIType(message.str());
+    }
 
-            switch (interface_type) {
-                case GI_INFO_TYPE_OBJECT:
-                    // if the interface type is an object, then we expect
-                    // the JS value to be a GIRObject so we can unwrap it
-                    // and pass the GObject pointer to the GIArgument's v_pointer.
-                    if (!js_value->IsObject()) {
-                        throw JSArgumentTypeError();
-                    } else {
-                        GIRObject *gir_object = Nan::ObjectWrap::Unwrap<GIRObject>(js_value->ToObject());
-                        argument_value.v_pointer = gir_object->get_gobject();
-                    }
-                    break;
+    return argument_value;
+}
 
-                case GI_INFO_TYPE_INTERFACE:
-                case GI_INFO_TYPE_VALUE:
-                case GI_INFO_TYPE_STRUCT:
-                case GI_INFO_TYPE_UNION:
-                case GI_INFO_TYPE_BOXED: {
-                    GType g_type = g_registered_type_info_get_g_type(interface_info.get());
-                    if (g_type_is_a(g_type, G_TYPE_VALUE)) {
-                        GValue gvalue = GIRValue::to_g_value(js_value, g_type);
-                        argument_value.v_pointer = g_boxed_copy(g_type, &gvalue); // FIXME: should we copy? where do
-                                                                                  // we deallocate?
-                    } else {
-                        GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(js_value->ToObject());
-                        argument_value.v_pointer = gir_struct->get_native_ptr();
-                    }
-                } break;
+/**
+ * converts a JS function to a callback using a pooled trampoline (see
+ * GIRClosure::acquire_trampoline) which is released when the callback's
+ * scope ends. Call scoped callbacks (the default when the typelib doesn't say)
+ * are released with the rest of the call's arguments. Notified callbacks are
+ * released by their destroy notify, if they don't have one they're never
+ * released because there's no way to know when native code is done with them
+ * (they're counted by Stats::ffi_trampolines_leaked). Async callbacks are
+ * released after they're first called.
+ */
+GIArgument Args::callback_to_g_type(ArgPlan &argument, Local<Value> js_value) {
+    if (!js_value->IsFunction()) {
+        throw JSArgumentTypeError();
+    }
 
-                case GI_INFO_TYPE_FLAGS:
-                case GI_INFO_TYPE_ENUM:
-                    argument_value.v_int = js_value->IntegerValue();
-                    break;
-
-                case GI_INFO_TYPE_CALLBACK:
-                    if (js_value->IsFunction()) {
-                        auto closure = GIRClosure::create_ffi(interface_info.get(), js_value.As<Function>());
-                        argument_value.v_pointer = closure;
-                    } else {
-                        throw JSArgumentTypeError();
-                    }
-                    break;
+    GIScopeType scope = argument.scope;
+    if (scope == GI_SCOPE_TYPE_INVALID) {
+        scope = GI_SCOPE_TYPE_CALL;
+    }
+    FFITrampoline *trampoline = GIRClosure::acquire_trampoline(argument.interface_info.get(),
+                                                               js_value.As<Function>(),
+                                                               scope);
+
+    bool has_closure = argument.closure_index >= 0 && this->plan.args[argument.closure_index].is_callback_data;
+    bool has_destroy = argument.destroy_index >= 0 && this->plan.args[argument.destroy_index].is_callback_data;
+    if (has_closure) {
+        this->in[this->plan.args[argument.closure_index].in_index].v_pointer = trampoline;
+    }
 
-                default:
-                    stringstream message;
-                    message << "argument's with interface type \"" << g_info_type_to_string(interface_type)
-                            << "\" is unsupported.";
-                    throw UnsupportedGIType(message.str());
+    switch (scope) {
+        case GI_SCOPE_TYPE_ASYNC:
+            // released by GIRClosure::ffi_closure_callback after it's first called
+            break;
+
+        case GI_SCOPE_TYPE_NOTIFIED:
+            if (has_destroy && has_closure) {
+                // the destroy notify is called with the user_data, which is the trampoline
+                this->in[this->plan.args[argument.destroy_index].in_index].v_pointer =
+                    (gpointer)GIRClosure::release_trampoline;
+            } else {
+                // nothing will tell us when native code is done with it
+                Stats::ffi_trampolines_leaked++;
             }
-        } break;
+            break;
+
+        default:
+            // call scope (which unannotated callbacks were given above)
+            this->arena.defer(GIRClosure::release_trampoline, trampoline);
+            break;
+    }
+
+    GIArgument argument_value;
+    argument_value.v_pointer = trampoline->native_closure;
+    return argument_value;
+}
+
+GIArgument Args::interface_to_g_type(GIBaseInfo *interface_info,
+                                     GIInfoType interface_type,
+                                     GType interface_g_type,
+                                     Local<Value> js_value) {
+    GIArgument argument_value;
+    argument_value.v_pointer = nullptr;
+
+    switch (interface_type) {
+        case GI_INFO_TYPE_OBJECT:
+            // if the interface type is an object, then we expect
+            // the JS value to be a GIRObject so we can unwrap it
+            // and pass the GObject pointer to the GIArgument's v_pointer.
+            if (!js_value->IsObject()) {
+                throw JSArgumentTypeError();
+            } else {
+                GIRObject *gir_object = Nan::ObjectWrap::Unwrap<GIRObject>(js_value->ToObject());
+                argument_value.v_pointer = gir_object->get_gobject();
+            }
+            break;
+
+        case GI_INFO_TYPE_INTERFACE:
+        case GI_INFO_TYPE_VALUE:
+        case GI_INFO_TYPE_STRUCT:
+        case GI_INFO_TYPE_UNION:
+        case GI_INFO_TYPE_BOXED:
+            if (g_type_is_a(interface_g_type, G_TYPE_VALUE)) {
+                // the caller owns the copy. Args converts GValue arguments itself
+                // (see Args::g_value_to_g_type) so this is only used for things
+                // like struct fields.
+                GValue gvalue = GIRValue::to_g_value(js_value, interface_g_type);
+                argument_value.v_pointer = g_boxed_copy(interface_g_type, &gvalue);
+                g_value_unset(&gvalue);
+            } else {
+                GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(js_value->ToObject());
+                argument_value.v_pointer = gir_struct->get_native_ptr();
+            }
+            break;
+
+        case GI_INFO_TYPE_FLAGS:
+        case GI_INFO_TYPE_ENUM:
+            argument_value.v_int = js_value->IntegerValue();
+            break;
+
+        case GI_INFO_TYPE_CALLBACK:
+            if (js_value->IsFunction()) {
+                auto closure = GIRClosure::create_ffi(interface_info, js_value.As<Function>());
+                argument_value.v_pointer = closure;
+            } else {
+                throw JSArgumentTypeError();
+            }
+            break;
 
         default:
             stringstream message;
-            message << "argument type \"" << g_type_tag_to_string(argument_type_tag) << "\" is unsupported.";
+            message << "argument's with interface type \"" << g_info_type_to_string(interface_type)
+                    << "\" is unsupported.";
             throw UnsupportedGIType(message.str());
     }
 
@@ -321,26 +876,49 @@ Local<Value> Args::from_g_type_array(GIArgument *arg, GITypeInfo *type, int arra
     GITypeTag param_tag = g_type_info_get_tag(element_type_info.get());
 
     switch (array_type_info) {
-        case GI_ARRAY_TYPE_C:
+        case GI_ARRAY_TYPE_C: {
+            bool is_numeric = !g_type_info_is_pointer(element_type_info.get()) &&
+                              Args::numeric_element_size(param_tag) > 0;
+            if (!is_numeric && !g_type_info_is_pointer(element_type_info.get())) {
+                break;
+            }
+            if (arg->v_pointer == nullptr) {
+                return Nan::Null();
+            }
+
+            // the array's length is either marked by a zero element, fixed
+            // or stored in another argument (which the caller passes in)
+            gsize element_size = is_numeric ? Args::numeric_element_size(param_tag) : sizeof(gpointer);
+            gint fixed_size = g_type_info_get_array_fixed_size(type);
+            gsize length;
             if (g_type_info_is_zero_terminated(type)) {
-                GIArgument element;
-                gpointer *native_array = (gpointer *)arg->v_pointer;
-                Local<Array> js_array = Nan::New<Array>();
-                for (int i = 0; native_array[i]; i++) {
-                    element.v_pointer = native_array[i];
-                    Local<Value> js_element = Args::from_g_type(&element, element_type_info.get(), 0);
-                    js_array->Set(i, js_element);
+                static const char zero_element[8] = {0};
+                char *element = (char *)arg->v_pointer;
+                for (length = 0; memcmp(element, zero_element, element_size) != 0; length++) {
+                    element += element_size;
                 }
-                return js_array;
+            } else if (fixed_size >= 0) {
+                length = fixed_size;
+            } else if (array_length >= 0) {
+                length = array_length;
             } else {
-                // use array_length param once the layers above this
-                // pas it correctly.
-                // the length param comes from the native function call's
-                // out arguments but, currently, it doesn't get passed own
-                // here correctly.
-                throw UnsupportedGIType("Converting non null terminated arrays is not yet supported");
+                throw UnsupportedGIType("Converting arrays without a known length is not yet supported");
             }
-            break;
+
+            // arrays of numbers are copied into a TypedArray in one go
+            if (is_numeric) {
+                return Args::numeric_array_to_js(arg->v_pointer, param_tag, length);
+            }
+
+            GIArgument element;
+            gpointer *native_array = (gpointer *)arg->v_pointer;
+            Local<Array> js_array = Nan::New<Array>(length);
+            for (gsize i = 0; i < length; i++) {
+                element.v_pointer = native_array[i];
+                js_array->Set(i, Args::from_g_type(&element, element_type_info.get(), -1));
+            }
+            return js_array;
+        }
         default:
             throw UnsupportedGIType("cannot convert native array type");
     }
@@ -351,9 +929,194 @@ Local<Value> Args::from_g_type_array(GIArgument *arg, GITypeInfo *type, int arra
     throw UnsupportedGIType(message.str());
 }
 
+/**
+ * Converts a GList or GSList to a JS array (or, if lazy lists are enabled,
+ * an iterable that converts each element when it's needed). If we own the
+ * list (or it's elements) then they're freed once they've been converted.
+ */
+Local<Value> Args::from_g_type_list(GIArgument *arg, GITypeInfo *type, GITransfer transfer) {
+    auto element_type_info = GIRInfoUniquePtr(g_type_info_get_param_type(type, 0));
+    bool is_slist = g_type_info_get_tag(type) == GI_TYPE_TAG_GSLIST;
+    gpointer list = arg->v_pointer;
+
+    if (Config::lazy_lists && Args::can_own_element(element_type_info.get())) {
+        return GIRListIterator::create(list, is_slist, element_type_info.get(), transfer);
+    }
+
+    Local<Array> js_array = Nan::New<Array>();
+    guint32 i = 0;
+    for (gpointer node = list; node != nullptr; node = Args::list_next(node, is_slist)) {
+        GIArgument element = Args::pointer_to_g_argument(Args::list_data(node, is_slist), element_type_info.get());
+        js_array->Set(i++, Args::from_g_type(&element, element_type_info.get(), -1));
+    }
+
+    if (transfer == GI_TRANSFER_EVERYTHING) {
+        for (gpointer node = list; node != nullptr; node = Args::list_next(node, is_slist)) {
+            Args::free_element(Args::list_data(node, is_slist), element_type_info.get());
+        }
+    }
+    if (transfer != GI_TRANSFER_NOTHING) {
+        Args::free_list(list, is_slist);
+    }
+    return js_array;
+}
+
+/**
+ * Converts a GHashTable to a plain JS object.
+ */
+Local<Value> Args::from_g_type_hash(GIArgument *arg, GITypeInfo *type, GITransfer transfer) {
+    GHashTable *hash_table = (GHashTable *)arg->v_pointer;
+    if (hash_table == nullptr) {
+        return Nan::Null();
+    }
+
+    auto key_type_info = GIRInfoUniquePtr(g_type_info_get_param_type(type, 0));
+    auto value_type_info = GIRInfoUniquePtr(g_type_info_get_param_type(type, 1));
+    Local<Object> js_object = Nan::New<Object>();
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, hash_table);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        GIArgument key_argument = Args::pointer_to_g_argument(key, key_type_info.get());
+        GIArgument value_argument = Args::pointer_to_g_argument(value, value_type_info.get());
+        Nan::Set(js_object,
+                 Args::from_g_type(&key_argument, key_type_info.get(), -1),
+                 Args::from_g_type(&value_argument, value_type_info.get(), -1));
+    }
+
+    // hash tables free their own keys and values (if they need to) so
+    // we only have to drop our reference.
+    if (transfer != GI_TRANSFER_NOTHING) {
+        g_hash_table_unref(hash_table);
+    }
+    return js_object;
+}
+
+/**
+ * Lists and hash tables store their elements as pointers, small integers are
+ * stored in the pointer itself (see GINT_TO_POINTER). This converts an element
+ * to a GIArgument that from_g_type() understands.
+ */
+GIArgument Args::pointer_to_g_argument(gpointer element, GITypeInfo *element_type_info) {
+    GIArgument argument;
+    argument.v_pointer = element;
+    switch (g_type_info_get_tag(element_type_info)) {
+        case GI_TYPE_TAG_BOOLEAN:
+            argument.v_boolean = GPOINTER_TO_INT(element);
+            break;
+        case GI_TYPE_TAG_INT8:
+            argument.v_int8 = GPOINTER_TO_INT(element);
+            break;
+        case GI_TYPE_TAG_UINT8:
+            argument.v_uint8 = GPOINTER_TO_UINT(element);
+            break;
+        case GI_TYPE_TAG_INT16:
+            argument.v_int16 = GPOINTER_TO_INT(element);
+            break;
+        case GI_TYPE_TAG_UINT16:
+            argument.v_uint16 = GPOINTER_TO_UINT(element);
+            break;
+        case GI_TYPE_TAG_INT32:
+            argument.v_int32 = GPOINTER_TO_INT(element);
+            break;
+        case GI_TYPE_TAG_UINT32:
+        case GI_TYPE_TAG_UNICHAR:
+            argument.v_uint32 = GPOINTER_TO_UINT(element);
+            break;
+        default:
+            break;
+    }
+    return argument;
+}
+
+/**
+ * returns true if we know how to copy and free elements of the given type,
+ * i.e. it's a string, an object or a boxed type.
+ */
+bool Args::can_own_element(GITypeInfo *element_type_info) {
+    switch (g_type_info_get_tag(element_type_info)) {
+        case GI_TYPE_TAG_UTF8:
+        case GI_TYPE_TAG_FILENAME:
+            return true;
+        case GI_TYPE_TAG_INTERFACE: {
+            auto interface_info = GIRInfoUniquePtr(g_type_info_get_interface(element_type_info));
+            if (!GI_IS_REGISTERED_TYPE_INFO(interface_info.get())) {
+                return false;
+            }
+            GType g_type = g_registered_type_info_get_g_type(interface_info.get());
+            return G_TYPE_IS_OBJECT(g_type) || G_TYPE_IS_INTERFACE(g_type) || G_TYPE_IS_BOXED(g_type);
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * returns a copy (or a new reference) of an element that can be released with free_element().
+ * The element must be of a type that can_own_element() accepts.
+ */
+gpointer Args::copy_element(gpointer element, GITypeInfo *element_type_info) {
+    if (element == nullptr) {
+        return nullptr;
+    }
+    if (g_type_info_get_tag(element_type_info) != GI_TYPE_TAG_INTERFACE) {
+        return g_strdup((const char *)element);
+    }
+    auto interface_info = GIRInfoUniquePtr(g_type_info_get_interface(element_type_info));
+    GType g_type = g_registered_type_info_get_g_type(interface_info.get());
+    if (G_TYPE_IS_BOXED(g_type)) {
+        return g_boxed_copy(g_type, element);
+    }
+    return g_object_ref(element);
+}
+
+/**
+ * releases an element of a list that we own. Elements we don't know how
+ * to free (see can_own_element()) are left alone.
+ */
+void Args::free_element(gpointer element, GITypeInfo *element_type_info) {
+    if (element == nullptr || !Args::can_own_element(element_type_info)) {
+        return;
+    }
+    if (g_type_info_get_tag(element_type_info) != GI_TYPE_TAG_INTERFACE) {
+        g_free(element);
+        return;
+    }
+    auto interface_info = GIRInfoUniquePtr(g_type_info_get_interface(element_type_info));
+    GType g_type = g_registered_type_info_get_g_type(interface_info.get());
+    if (G_TYPE_IS_BOXED(g_type)) {
+        g_boxed_free(g_type, element);
+    } else {
+        g_object_unref(element);
+    }
+}
+
+// GList and GSList are handled together, these helpers hide the difference.
+
+gpointer Args::list_next(gpointer node, bool is_slist) {
+    return is_slist ? (gpointer)((GSList *)node)->next : (gpointer)((GList *)node)->next;
+}
+
+gpointer &Args::list_data(gpointer node, bool is_slist) {
+    return is_slist ? ((GSList *)node)->data : ((GList *)node)->data;
+}
+
+gpointer Args::copy_list(gpointer list, bool is_slist) {
+    return is_slist ? (gpointer)g_slist_copy((GSList *)list) : (gpointer)g_list_copy((GList *)list);
+}
+
+void Args::free_list(gpointer list, bool is_slist) {
+    if (is_slist) {
+        g_slist_free((GSList *)list);
+    } else {
+        g_list_free((GList *)list);
+    }
+}
+
 // TODO: refactor this function and most of the code below this.
 // can we reuse code from GIRValue?
-Local<Value> Args::from_g_type(GIArgument *arg, GITypeInfo *type, int array_length) {
+Local<Value> Args::from_g_type(GIArgument *arg, GITypeInfo *type, int array_length, GITransfer transfer) {
     GITypeTag tag = g_type_info_get_tag(type);
 
     switch (tag) {
@@ -382,18 +1145,10 @@ Local<Value> Args::from_g_type(GIArgument *arg, GITypeInfo *type, int array_leng
             return Nan::New(arg->v_uint32);
 
         case GI_TYPE_TAG_INT64:
-            // the ECMA script spec doesn't support int64 values
-            // and V8 internally stores them as doubles.
-            // This will lose precision if the original value
-            // has more than 53 significant binary digits.
-            return Nan::New(static_cast<double>(arg->v_int64));
+            return Int64::from_int64(arg->v_int64);
 
         case GI_TYPE_TAG_UINT64:
-            // the ECMA script spec doesn't support uint64 values
-            // and V8 internally stores them as doubles.
-            // This will lose precision if the original value
-            // has more than 53 significant binary digits.
-            return Nan::New(static_cast<double>(arg->v_uint64));
+            return Int64::from_uint64(arg->v_uint64);
 
         case GI_TYPE_TAG_FLOAT:
             return Nan::New(arg->v_float);
@@ -421,7 +1176,7 @@ Local<Value> Args::from_g_type(GIArgument *arg, GITypeInfo *type, int array_leng
                     if (arg->v_pointer == nullptr) {
                         return Nan::Null();
                     }
-                    return GIRObject::from_existing(G_OBJECT(arg->v_pointer), interface_info);
+                    return GIRObject::from_existing(G_OBJECT(arg->v_pointer), interface_info, transfer);
 
                 case GI_INFO_TYPE_INTERFACE:
                 case GI_INFO_TYPE_UNION:
@@ -448,11 +1203,10 @@ Local<Value> Args::from_g_type(GIArgument *arg, GITypeInfo *type, int array_leng
         } break;
 
         case GI_TYPE_TAG_GLIST:
-            return Nan::Undefined();
         case GI_TYPE_TAG_GSLIST:
-            return Nan::Undefined();
+            return Args::from_g_type_list(arg, type, transfer);
         case GI_TYPE_TAG_GHASH:
-            return Nan::Undefined();
+            return Args::from_g_type_hash(arg, type, transfer);
         case GI_TYPE_TAG_ERROR:
             return Nan::Undefined();
         case GI_TYPE_TAG_UNICHAR:
@@ -5,6 +5,9 @@
 #include <nan.h>
 #include <v8.h>
 #include <vector>
+#include "call_plan.h"
+#include "internal/ScratchArena.h"
+#include "internal/SmallVector.h"
 #include "util.h"
 
 namespace gir {
@@ -12,30 +15,82 @@ namespace gir {
 using namespace std;
 using namespace v8;
 
+// the vast majority of native functions take far fewer than 16 arguments
+// so Args can hold them without allocating.
+using ArgumentVector = SmallVector<GIArgument, 16>;
+
 class Args {
 public:
-    vector<GIArgument> in;
-    vector<GIArgument> out;
+    ArgumentVector in;
+    ArgumentVector out;
 
-    Args(GICallableInfo *callable_info);
+    Args(CallPlan &plan);
 
     void load_js_arguments(const Nan::FunctionCallbackInfo<Value> &js_callback_info);
     void load_context(GObject *this_object);
 
+    GIArgument *in_value(ArgPlan &argument);
+    GIArgument *out_value(ArgPlan &argument);
+    int array_length(int length_index);
+
 private:
-    GIRInfoUniquePtr callable_info;
-    GIArgument get_in_argument_value(const Local<Value> &js_value, GIArgInfo &argument_info);
-    GIArgument get_out_argument_value(GIArgInfo &argument_info);
+    CallPlan &plan;
+
+    // owns any memory that's only needed for the duration of the native call
+    // (converted strings, temporary GValues, caller-allocated out arguments).
+    // it's all released when Args is destroyed.
+    ScratchArena arena;
+
+    GIArgument arg_to_g_type(ArgPlan &argument, Local<Value> js_value);
+    GIArgument string_to_g_type(GITransfer transfer, Local<Value> js_value);
+    GIArgument g_value_to_g_type(ArgPlan &argument, Local<Value> js_value);
+    GIArgument array_to_g_type(ArgPlan &argument, Local<Value> js_value);
+    GIArgument pointer_array_to_g_type(ArgPlan &argument, Local<Value> js_value);
+    GIArgument list_to_g_type(ArgPlan &argument, Local<Value> js_value);
+    GIArgument callback_to_g_type(ArgPlan &argument, Local<Value> js_value);
+    gpointer pointer_element_to_g_type(GITypeInfo *element_type_info,
+                                       GITransfer element_transfer,
+                                       Local<Value> js_element);
+    void *allocate_array(ArgPlan &argument, gsize byte_length);
+    void set_array_length(ArgPlan &array_argument, gsize length);
+    void load_array_length_argument(ArgPlan &argument);
+    GIArgument get_out_argument_value(ArgPlan &argument);
+    GIArgument alloc_out_array(ArgPlan &argument);
+    GIArgument *alloc_argument_value();
+    static gint64 integer_from_g_type(GIArgument *value, GITypeTag type_tag);
+    static void integer_to_g_type(GIArgument *value, GITypeTag type_tag, gint64 integer);
     static GITypeTag map_g_type_tag(GITypeTag type);
+    static gsize numeric_element_size(GITypeTag element_tag);
+    static bool typed_array_matches(Local<Value> js_value, GITypeTag element_tag);
+    static Local<Value> numeric_array_to_js(gpointer native_array, GITypeTag element_tag, gsize length);
+    static GIArgument tag_to_g_type(GITypeTag argument_type_tag, Local<Value> js_value);
+    static GIArgument interface_to_g_type(GIBaseInfo *interface_info,
+                                          GIInfoType interface_type,
+                                          GType interface_g_type,
+                                          Local<Value> js_value);
 
 public:
     // these functions are legacy and need to be refactored
     // there are many missing features within them as well such as missing type conversions (types that aren't supported
     // like structs.)
-    static GIArgument arg_to_g_type(GIArgInfo &argument_info, Local<Value> js_value);
     static GIArgument type_to_g_type(GITypeInfo &argument_type_info, Local<Value> js_value);
     static Local<Value> from_g_type_array(GIArgument *arg, GIArgInfo *info, int array_length);
-    static Local<Value> from_g_type(GIArgument *arg, GITypeInfo *type_info, int array_length);
+    static Local<Value> from_g_type(GIArgument *arg,
+                                    GITypeInfo *type_info,
+                                    int array_length,
+                                    GITransfer transfer = GI_TRANSFER_NOTHING);
+    static Local<Value> from_g_type_list(GIArgument *arg, GITypeInfo *type_info, GITransfer transfer);
+    static Local<Value> from_g_type_hash(GIArgument *arg, GITypeInfo *type_info, GITransfer transfer);
+
+    // helpers for the elements of lists and hash tables
+    static GIArgument pointer_to_g_argument(gpointer element, GITypeInfo *element_type_info);
+    static bool can_own_element(GITypeInfo *element_type_info);
+    static gpointer copy_element(gpointer element, GITypeInfo *element_type_info);
+    static void free_element(gpointer element, GITypeInfo *element_type_info);
+    static gpointer list_next(gpointer node, bool is_slist);
+    static gpointer &list_data(gpointer node, bool is_slist);
+    static gpointer copy_list(gpointer list, bool is_slist);
+    static void free_list(gpointer list, bool is_slist);
 };
 
 } // namespace gir
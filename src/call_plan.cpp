@@ -0,0 +1,180 @@
+#include "call_plan.h"
+
+namespace gir {
+
+CallPlan::CallPlan(GIFunctionInfo *function_info) : function_info(g_base_info_ref(function_info)) {
+    this->is_method = g_callable_info_is_method(function_info);
+    this->can_throw = g_callable_info_can_throw_gerror(function_info);
+
+    g_callable_info_load_return_type(function_info, &this->return_type_info);
+    this->return_type_tag = g_type_info_get_tag(&this->return_type_info);
+    this->return_transfer = g_callable_info_get_caller_owns(function_info);
+    this->skip_return = g_callable_info_skip_return(function_info) || this->return_type_tag == GI_TYPE_TAG_VOID;
+
+    // methods take their instance as the first "in" argument
+    this->n_in_args = this->is_method ? 1 : 0;
+
+    // reserve all the space we need up front so the vector never reallocates
+    // (see the comment on CallPlan::args)
+    int n_args = g_callable_info_get_n_args(function_info);
+    this->args = vector<ArgPlan>(n_args);
+    for (int i = 0; i < n_args; i++) {
+        this->load_arg(i, this->args[i]);
+    }
+
+    // array lengths can only be marked once every argument has been loaded because
+    // an array's length argument may come before or after it.
+    if (this->return_type_tag == GI_TYPE_TAG_ARRAY) {
+        this->return_array_length_index = g_type_info_get_array_length(&this->return_type_info);
+        this->mark_array_length(this->return_array_length_index, GI_DIRECTION_OUT);
+    }
+    for (ArgPlan &arg : this->args) {
+        this->mark_array_length(arg.array_length_index, arg.direction);
+    }
+    for (int i = 0; i < n_args; i++) {
+        this->mark_callback_data(this->args[i].closure_index, i);
+        this->mark_callback_data(this->args[i].destroy_index, i);
+    }
+
+    // JS only passes the arguments that aren't hidden, in order, and gets
+    // back the OUT arguments that aren't hidden.
+    int n_js_args = 0;
+    for (ArgPlan &arg : this->args) {
+        if (arg.is_array_length || arg.is_callback_data) {
+            continue;
+        }
+        if (arg.direction == GI_DIRECTION_IN || arg.direction == GI_DIRECTION_INOUT) {
+            arg.js_index = n_js_args++;
+        }
+        if (arg.direction == GI_DIRECTION_OUT || arg.direction == GI_DIRECTION_INOUT) {
+            this->n_js_out_args++;
+        }
+    }
+
+    this->n_ffi_args = n_args + (this->is_method ? 1 : 0) + (this->can_throw ? 1 : 0);
+}
+
+/**
+ * resolves the native symbol and prepares the ffi_cif that we'll use to call
+ * it. This is done the first time the function is called rather than when the
+ * plan is built, because plans are built for every function in a namespace and
+ * most of them are never called. Failing here isn't fatal, the caller falls
+ * back to g_function_info_invoke() which will report the error.
+ * Returns true if the invoker can be used.
+ */
+bool CallPlan::prepare_invoker() {
+    if (!this->invoker_prepared) {
+        this->invoker_prepared = true;
+        if (!CallPlan::fast_invoke_disabled()) {
+            GError *error = nullptr;
+            this->has_invoker = g_function_info_prep_invoker(this->function_info.get(), &this->invoker, &error);
+            if (error != nullptr) {
+                g_error_free(error);
+            }
+        }
+    }
+    return this->has_invoker;
+}
+
+CallPlan::~CallPlan() {
+    if (this->has_invoker) {
+        g_function_invoker_destroy(&this->invoker);
+    }
+}
+
+GIFunctionInfo *CallPlan::get_function_info() {
+    return this->function_info.get();
+}
+
+/**
+ * The fast invocation path can be disabled by setting the NODE_GIR_LEGACY_INVOKE
+ * environment variable. This is useful for comparing the two paths (see bench/invoke.js)
+ * and for ruling the fast path out when debugging a crash.
+ */
+bool CallPlan::fast_invoke_disabled() {
+    static bool disabled = g_getenv("NODE_GIR_LEGACY_INVOKE") != nullptr;
+    return disabled;
+}
+
+/**
+ * hides the length argument of an array (or the return value) when it can be
+ * filled in without JS: from the array's length when the array is passed in,
+ * or by the native function when the length is an OUT argument. An IN length
+ * of an OUT array (e.g. the size of a buffer the caller allocates) can only
+ * come from JS so it stays visible.
+ */
+void CallPlan::mark_array_length(int index, GIDirection array_direction) {
+    if (index < 0 || index >= (int)this->args.size()) {
+        return;
+    }
+    ArgPlan &length_arg = this->args[index];
+    if (array_direction != GI_DIRECTION_OUT || length_arg.direction != GI_DIRECTION_IN) {
+        length_arg.is_array_length = true;
+    }
+}
+
+/**
+ * marks the argument at index as the user_data or destroy notify of the
+ * callback argument at callback_index. Only IN arguments can be filled in by
+ * the callback, a typelib that says otherwise is ignored.
+ */
+void CallPlan::mark_callback_data(int index, int callback_index) {
+    if (index >= 0 && index < (int)this->args.size() && index != callback_index &&
+        this->args[index].direction == GI_DIRECTION_IN) {
+        this->args[index].is_callback_data = true;
+    }
+}
+
+void CallPlan::load_arg(int index, ArgPlan &arg) {
+    g_callable_info_load_arg(this->function_info.get(), index, &arg.arg_info);
+    g_arg_info_load_type(&arg.arg_info, &arg.type_info);
+
+    arg.name = g_base_info_get_name(&arg.arg_info);
+    arg.direction = g_arg_info_get_direction(&arg.arg_info);
+    arg.type_tag = g_type_info_get_tag(&arg.type_info);
+    arg.transfer = g_arg_info_get_ownership_transfer(&arg.arg_info);
+    arg.may_be_null = g_arg_info_may_be_null(&arg.arg_info);
+    arg.caller_allocates = g_arg_info_is_caller_allocates(&arg.arg_info);
+
+    if (arg.type_tag == GI_TYPE_TAG_INTERFACE) {
+        arg.interface_info = GIRInfoUniquePtr(g_type_info_get_interface(&arg.type_info));
+        arg.interface_type = g_base_info_get_type(arg.interface_info.get());
+        if (GI_IS_REGISTERED_TYPE_INFO(arg.interface_info.get())) {
+            arg.interface_g_type = g_registered_type_info_get_g_type(arg.interface_info.get());
+        }
+    }
+
+    if (arg.interface_type == GI_INFO_TYPE_CALLBACK) {
+        arg.scope = g_arg_info_get_scope(&arg.arg_info);
+        arg.closure_index = g_arg_info_get_closure(&arg.arg_info);
+        arg.destroy_index = g_arg_info_get_destroy(&arg.arg_info);
+    }
+
+    if (arg.type_tag == GI_TYPE_TAG_ARRAY) {
+        arg.array_type = g_type_info_get_array_type(&arg.type_info);
+        arg.array_element_type_info = GIRInfoUniquePtr(g_type_info_get_param_type(&arg.type_info, 0));
+        arg.array_element_tag = g_type_info_get_tag(arg.array_element_type_info.get());
+        arg.array_element_is_pointer = g_type_info_is_pointer(arg.array_element_type_info.get());
+        arg.array_zero_terminated = g_type_info_is_zero_terminated(&arg.type_info);
+        arg.array_fixed_size = g_type_info_get_array_fixed_size(&arg.type_info);
+        arg.array_length_index = g_type_info_get_array_length(&arg.type_info);
+    }
+
+    if (arg.direction == GI_DIRECTION_IN || arg.direction == GI_DIRECTION_INOUT) {
+        arg.in_index = this->n_in_args++;
+    }
+
+    if (arg.direction == GI_DIRECTION_OUT || arg.direction == GI_DIRECTION_INOUT) {
+        arg.out_index = this->n_out_args++;
+    }
+
+    if (arg.direction == GI_DIRECTION_OUT && arg.caller_allocates) {
+        if (arg.interface_type == GI_INFO_TYPE_STRUCT) {
+            arg.caller_allocates_size = g_struct_info_get_size((GIStructInfo *)arg.interface_info.get());
+        } else if (arg.interface_type == GI_INFO_TYPE_UNION) {
+            arg.caller_allocates_size = g_union_info_get_size((GIUnionInfo *)arg.interface_info.get());
+        }
+    }
+}
+
+} // namespace gir
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <girepository.h>
+#include <girffi.h>
+#include <glib.h>
+#include <vector>
+#include "util.h"
+
+namespace gir {
+
+using namespace std;
+
+/**
+ * An ArgPlan is the precomputed description of a single native argument.
+ * Everything the call path needs to know about an argument is read from the
+ * typelib once, when the owning CallPlan is built, so that calling the function
+ * doesn't need to query the typelib again.
+ */
+struct ArgPlan {
+    GIArgInfo arg_info;
+    GITypeInfo type_info; // loaded from arg_info, so it must not outlive (or move away from) it
+    const char *name;
+    GIDirection direction;
+    GITypeTag type_tag;
+    GITransfer transfer;
+    bool may_be_null;
+    bool caller_allocates;
+
+    // these are only set if the argument's type_tag is GI_TYPE_TAG_INTERFACE
+    GIRInfoUniquePtr interface_info = nullptr;
+    GIInfoType interface_type = GI_INFO_TYPE_INVALID;
+    GType interface_g_type = G_TYPE_NONE;
+
+    // these are only set if the argument's type_tag is GI_TYPE_TAG_ARRAY
+    GIArrayType array_type = GI_ARRAY_TYPE_C;
+    GIRInfoUniquePtr array_element_type_info = nullptr;
+    GITypeTag array_element_tag = GI_TYPE_TAG_VOID;
+    bool array_element_is_pointer = false;
+    bool array_zero_terminated = false;
+    int array_fixed_size = -1;
+    int array_length_index = -1; // the native index of the argument that holds the array's length
+
+    // true if this argument is the hidden length of another argument (or the return
+    // value) that's an array. Hidden lengths are filled in from the array's length or
+    // used to convert the array back to JS. The IN length of an OUT array isn't hidden
+    // (see CallPlan::mark_array_length).
+    bool is_array_length = false;
+
+    // these are only set if the argument is a callback. closure_index and
+    // destroy_index are the native indexes of the callback's user_data and
+    // destroy notify arguments, or -1 if it doesn't have them.
+    GIScopeType scope = GI_SCOPE_TYPE_INVALID;
+    int closure_index = -1;
+    int destroy_index = -1;
+
+    // true if this argument is the user_data or destroy notify of a callback
+    // argument. They're hidden from JS, the callback argument fills them in.
+    bool is_callback_data = false;
+
+    // the number of bytes we need to allocate for caller-allocates OUT arguments
+    // this is 0 if the argument isn't caller-allocates or it's type isn't supported.
+    gsize caller_allocates_size = 0;
+
+    // the position of this argument in the JS function call's arguments
+    // or -1 if it isn't passed in from JS (OUT and array length arguments)
+    int js_index = -1;
+    // the position of this argument in Args::in and Args::out
+    // or -1 if it doesn't appear in that list. For methods, Args::in[0]
+    // is reserved for the instance so in_index starts at 1.
+    int in_index = -1;
+    int out_index = -1;
+};
+
+/**
+ * A CallPlan is a "compiled" version of a GIFunctionInfo. It's built once per
+ * function (when the function's JS template is created) and is then reused
+ * for every call to that function.
+ */
+class CallPlan {
+public:
+    // the plan for each native argument, in the native argument order.
+    // this vector must never be resized after it's been built because
+    // each ArgPlan::type_info points to it's sibling ArgPlan::arg_info.
+    vector<ArgPlan> args;
+
+    GITypeInfo return_type_info;
+    GITypeTag return_type_tag;
+    GITransfer return_transfer;
+    bool skip_return;
+    bool is_method;
+    bool can_throw;
+
+    // the native index of the argument that holds the length of the returned array, or -1
+    int return_array_length_index = -1;
+
+    int n_in_args = 0;
+    int n_out_args = 0;
+
+    // the number of OUT and INOUT arguments that are returned to JS
+    // (i.e. not counting array lengths)
+    int n_js_out_args = 0;
+
+    // the total number of arguments the native function takes at the ABI level
+    // i.e. including the instance argument for methods and the GError** for
+    // functions that throw.
+    int n_ffi_args = 0;
+
+    // the native symbol is resolved and it's ffi_cif prepared once, the first
+    // time the function is called (see prepare_invoker). If that fails (or the
+    // fast path has been disabled) then has_invoker is false and calls fall
+    // back to g_function_info_invoke().
+    GIFunctionInvoker invoker;
+    bool has_invoker = false;
+
+    CallPlan(GIFunctionInfo *function_info);
+    CallPlan(const CallPlan &) = delete;
+    CallPlan &operator=(const CallPlan &) = delete;
+    ~CallPlan();
+
+    GIFunctionInfo *get_function_info();
+    bool prepare_invoker();
+
+private:
+    GIRInfoUniquePtr function_info;
+    bool invoker_prepared = false;
+
+    static bool fast_invoke_disabled();
+
+    void load_arg(int index, ArgPlan &arg);
+    void mark_array_length(int index, GIDirection array_direction);
+    void mark_callback_data(int index, int callback_index);
+};
+
+} // namespace gir
@@ -1,99 +1,418 @@
 #include "closure.h"
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <unordered_map>
 #include "arguments.h"
 #include "exceptions.h"
+#include "stats.h"
 #include "values.h"
 
 namespace gir {
 
 /**
- * returns NULL if the signal doesn't exist
- * Perhaps we should throw a JS exception instead?
- * Perhaps we should throw a c++ exception instead?
- * Perhaps we should redesign this function to not have this sort of
- * error condition, it's suppose to be a 'constructor' function (constructing a closure struct)
- * and constructors shouldn't really 'error' like this.
+ * creates a GClosure for a JS function. The GIRClosure's memory is allocated
+ * (and zeroed) by g_closure_new_simple so it's constructor is never run.
  */
-GClosure *GIRClosure::create(GICallableInfo *callable_info, Local<Function> callback) {
-    // create a custom GClosure
+GIRClosure *GIRClosure::create_closure(Local<Function> callback) {
     GClosure *closure = g_closure_new_simple(sizeof(GIRClosure), nullptr);
-    GIRClosure *gir_signal_closure = (GIRClosure *)closure;
+    GIRClosure *gir_closure = (GIRClosure *)closure;
 
     // connect the finalaize notifier and marshaller
     g_closure_add_finalize_notifier(closure, nullptr, GIRClosure::finalize_handler);
     g_closure_set_marshal(closure, GIRClosure::closure_marshal);
 
-    gir_signal_closure->callback = PersistentFunction(callback);
+    gir_closure->callback = PersistentFunction(callback);
+    return gir_closure;
+}
+
+GClosure *GIRClosure::create(GICallableInfo *callable_info, Local<Function> callback) {
+    GIRClosure *gir_closure = GIRClosure::create_closure(callback);
 
     // we need to ref the callable_info because we want to keep it
     g_base_info_ref(callable_info);
-    gir_signal_closure->callable_info = GIRInfoUniquePtr(callable_info);
+    gir_closure->callable_info = GIRInfoUniquePtr(callable_info);
+
+    return (GClosure *)gir_closure;
+}
 
-    return closure;
+/**
+ * creates a closure that can be connected to the given signal
+ */
+GClosure *GIRClosure::create_for_signal(guint signal_id, Local<Function> callback, const SignalOptions &options) {
+    GIRClosure *gir_closure = GIRClosure::create_closure(callback);
+    gir_closure->signal_plan = SignalPlan::get(signal_id);
+    // the closure's memory isn't constructed (see create_closure) so the
+    // options, which own vectors, are kept on the heap.
+    gir_closure->signal_options = new SignalOptions(options);
+    // the JS function is kept alive by the wrapper of the object it's connected
+    // to (see GIRObject::keep_signal_callback), not by the closure. Otherwise a
+    // handler that captures it's own wrapper would keep the wrapper (and so the
+    // GObject) alive forever.
+    gir_closure->callback.v8::PersistentBase<Function>::SetWeak();
+    return (GClosure *)gir_closure;
+}
+
+/**
+ * tells a signal closure which handler id it was connected with, closures
+ * connected with SignalOptions::once need it to disconnect themselves.
+ */
+void GIRClosure::set_handler_id(GClosure *closure, gulong handler_id) {
+    ((GIRClosure *)closure)->handler_id = handler_id;
+}
+
+/**
+ * returns the plan for the given signal, building it the first time it's needed.
+ * Plans (like the GValue converters they use) live for as long as the process does.
+ */
+SignalPlan *SignalPlan::get(guint signal_id) {
+    static unordered_map<guint, SignalPlan *> plans;
+    auto found = plans.find(signal_id);
+    if (found != plans.end()) {
+        return found->second;
+    }
+
+    GSignalQuery signal_query;
+    g_signal_query(signal_id, &signal_query);
+
+    SignalPlan *plan = new SignalPlan();
+    plan->n_params = signal_query.n_params + 1;
+    plan->param_types.reserve(plan->n_params);
+    plan->param_converters.reserve(plan->n_params);
+    plan->param_types.push_back(signal_query.itype);
+    plan->param_converters.push_back(&GIRValue::get_converter(signal_query.itype));
+    for (guint i = 0; i < signal_query.n_params; i++) {
+        // the static scope flag is stored in the param's type
+        GType param_type = signal_query.param_types[i] & ~G_SIGNAL_TYPE_STATIC_SCOPE;
+        plan->param_types.push_back(param_type);
+        plan->param_converters.push_back(&GIRValue::get_converter(param_type));
+    }
+
+    plan->return_type = signal_query.return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE;
+    plan->return_converter = nullptr;
+    if (plan->return_type != G_TYPE_NONE) {
+        plan->return_converter = &GIRValue::get_converter(plan->return_type);
+    }
+
+    plans[signal_id] = plan;
+    return plan;
+}
+
+/**
+ * whether a param value can be converted with the plan's converter. The
+ * instance (param 0) is usually a subclass of the type the signal was defined
+ * on, but it always has a wrapper (the wrapper holds the callback, see
+ * create_for_signal) so the planned object converter returns it. Other params
+ * must match exactly so objects without a wrapper get their own type's info.
+ */
+bool SignalPlan::matches(guint index, GType g_type) const {
+    if (index == 0) {
+        return g_type_is_a(g_type, this->param_types[0]);
+    }
+    return g_type == this->param_types[index];
 }
 
 void GIRClosure::ffi_closure_callback(ffi_cif *cif, void *result, void **args, gpointer user_data) {
-    GIRClosure *gir_closure = static_cast<GIRClosure *>(user_data);
-    int n_native_args = g_callable_info_get_n_args(gir_closure->callable_info.get());
+    FFITrampoline *trampoline = static_cast<FFITrampoline *>(user_data);
+    // the result is 0 unless the JS callback returns a value, e.g. when it
+    // throws, rather than whatever was left in libffi's return value.
+    if (cif->rtype->type != FFI_TYPE_VOID) {
+        memset(result, 0, std::max<size_t>(sizeof(ffi_arg), cif->rtype->size));
+    }
+
+    GIRClosure *gir_closure = (GIRClosure *)trampoline->closure;
+    if (gir_closure == nullptr) {
+        // native code called a callback after it's scope ended
+        g_warning("node-gir: a callback of type %s was called after it was released", trampoline->signature.c_str());
+        return;
+    }
+
+    trampoline->n_calls++;
+    GIRClosure::call_js_callback(trampoline, gir_closure, result, args);
+    // async callbacks are only called once. The trampoline is released while
+    // it's still being called so release_trampoline won't free it before
+    // libffi has returned through it.
+    if (trampoline->scope == GI_SCOPE_TYPE_ASYNC) {
+        GIRClosure::release_trampoline(trampoline);
+    }
+    trampoline->n_calls--;
+}
+
+/**
+ * converts the native arguments of a trampoline call to JS, calls the JS
+ * function and stores it's result. Errors are thrown as JS exceptions because
+ * C++ exceptions can't unwind through libffi and the native caller.
+ */
+void GIRClosure::call_js_callback(FFITrampoline *trampoline, GIRClosure *gir_closure, void *result, void **args) {
+    Nan::HandleScope scope;
     vector<Local<Value>> js_args;
-    js_args.reserve(n_native_args);
-    // FIXME: no clue why this works but it does.
-    // if someone could explain it (or show why it's likely very broken)
-    // that'd be amazing.
+    js_args.reserve(trampoline->arg_type_infos.size());
+    // libffi gives us an array with a pointer to each argument's value. The
+    // values are in register or stack slots that are at least as big as a
+    // GIArgument, so each one can be read as a GIArgument and from_g_type only
+    // reads the member for the argument's type.
     GIArgument **gi_args = reinterpret_cast<GIArgument **>(args);
+    try {
+        for (size_t i = 0; i < trampoline->arg_type_infos.size(); i++) {
+            GITypeInfo *arg_type_info = trampoline->arg_type_infos[i].get();
+            if (arg_type_info == nullptr) {
+                continue;
+            }
+            js_args.push_back(Args::from_g_type(gi_args[i], arg_type_info, -1));
+        }
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
+        return;
+    }
+
+    Local<Function> js_callback = Nan::New<Function>(gir_closure->callback);
+    Nan::MaybeLocal<Value> js_result = Nan::Call(js_callback,
+                                                 Nan::GetCurrentContext()->Global(),
+                                                 js_args.size(),
+                                                 js_args.data());
+    if (js_result.IsEmpty()) {
+        return;
+    }
+    try {
+        GIRClosure::store_ffi_return_value(trampoline->return_type_info.get(), js_result.ToLocalChecked(), result);
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
+    }
+}
+
+/**
+ * converts the JS callback's result to the callback's return type and writes
+ * it to libffi's return value. libffi expects integer return values smaller
+ * than a register to be widened to ffi_arg.
+ */
+void GIRClosure::store_ffi_return_value(GITypeInfo *return_type_info, Local<Value> js_result, void *result) {
+    GITypeTag return_tag = g_type_info_get_tag(return_type_info);
+    if (return_tag == GI_TYPE_TAG_VOID && !g_type_info_is_pointer(return_type_info)) {
+        return;
+    }
+    if (js_result->IsNullOrUndefined()) {
+        memset(result, 0, sizeof(ffi_arg));
+        return;
+    }
+
+    GIArgument value = Args::type_to_g_type(*return_type_info, js_result);
+    switch (return_tag) {
+        case GI_TYPE_TAG_BOOLEAN:
+            *(ffi_sarg *)result = value.v_boolean;
+            break;
+        case GI_TYPE_TAG_INT8:
+            *(ffi_sarg *)result = value.v_int8;
+            break;
+        case GI_TYPE_TAG_UINT8:
+            *(ffi_arg *)result = value.v_uint8;
+            break;
+        case GI_TYPE_TAG_INT16:
+            *(ffi_sarg *)result = value.v_int16;
+            break;
+        case GI_TYPE_TAG_UINT16:
+            *(ffi_arg *)result = value.v_uint16;
+            break;
+        case GI_TYPE_TAG_INT32:
+            *(ffi_sarg *)result = value.v_int32;
+            break;
+        case GI_TYPE_TAG_UINT32:
+        case GI_TYPE_TAG_UNICHAR:
+            *(ffi_arg *)result = value.v_uint32;
+            break;
+        case GI_TYPE_TAG_INT64:
+            *(gint64 *)result = value.v_int64;
+            break;
+        case GI_TYPE_TAG_UINT64:
+            *(guint64 *)result = value.v_uint64;
+            break;
+        case GI_TYPE_TAG_FLOAT:
+            *(gfloat *)result = value.v_float;
+            break;
+        case GI_TYPE_TAG_DOUBLE:
+            *(gdouble *)result = value.v_double;
+            break;
+        case GI_TYPE_TAG_INTERFACE: {
+            // enums and flags are returned as integers, everything else is a pointer
+            auto interface_info = GIRInfoUniquePtr(g_type_info_get_interface(return_type_info));
+            GIInfoType interface_type = g_base_info_get_type(interface_info.get());
+            if (interface_type == GI_INFO_TYPE_ENUM || interface_type == GI_INFO_TYPE_FLAGS) {
+                *(ffi_sarg *)result = value.v_int;
+            } else {
+                *(gpointer *)result = value.v_pointer;
+            }
+            break;
+        }
+        default:
+            *(gpointer *)result = value.v_pointer;
+            break;
+    }
+}
+
+/**
+ * the key of the pool a callback's trampolines are kept in. Trampolines can
+ * only be shared by callbacks with the same signature so the key is the
+ * callback type's full name, e.g. "GLib.SourceFunc".
+ */
+string GIRClosure::get_signature(GICallableInfo *callable_info) {
+    const char *name = g_base_info_get_name(callable_info);
+    if (name == nullptr) {
+        return string();
+    }
+    return string(g_base_info_get_namespace(callable_info)) + "." + name;
+}
+
+/**
+ * the trampolines that aren't in use, by signature (see get_signature)
+ */
+static unordered_map<string, vector<FFITrampoline *>> free_trampolines;
+
+/**
+ * returns a trampoline for the callback type that calls the given JS function.
+ * A released trampoline with the same signature is reused when there is one,
+ * otherwise a new one is prepared. The caller must release the trampoline once
+ * the callback's scope ends:
+ * - call: when the native function returns
+ * - async: released automatically after it's first called
+ * - notified: when native code calls the destroy notify
+ */
+FFITrampoline *GIRClosure::acquire_trampoline(GICallableInfo *callable_info,
+                                              Local<Function> callback,
+                                              GIScopeType scope) {
+    string signature = GIRClosure::get_signature(callable_info);
+    FFITrampoline *trampoline = nullptr;
+
+    auto pool = free_trampolines.find(signature);
+    if (!signature.empty() && pool != free_trampolines.end() && !pool->second.empty()) {
+        trampoline = pool->second.back();
+        pool->second.pop_back();
+    } else {
+        trampoline = new FFITrampoline();
+        g_base_info_ref(callable_info);
+        trampoline->callable_info = GIRInfoUniquePtr(callable_info);
+        trampoline->signature = signature;
+        GIRClosure::load_trampoline_types(trampoline);
+        trampoline->native_closure = g_callable_info_prepare_closure(callable_info,
+                                                                     &trampoline->cif,
+                                                                     GIRClosure::ffi_closure_callback,
+                                                                     trampoline);
+        Stats::ffi_trampolines_prepared++;
+    }
+
+    trampoline->scope = scope;
+    trampoline->closure = GIRClosure::create(trampoline->callable_info.get(), callback);
+    return trampoline;
+}
+
+/**
+ * loads the type of each of the callback's arguments (and it's return type)
+ * once, when the trampoline is prepared, so calling it doesn't need to query
+ * the typelib. void arguments (i.e. user_data) aren't passed to JS so their
+ * type is left as nullptr.
+ */
+void GIRClosure::load_trampoline_types(FFITrampoline *trampoline) {
+    GICallableInfo *callable_info = trampoline->callable_info.get();
+    int n_native_args = g_callable_info_get_n_args(callable_info);
+    trampoline->arg_type_infos.reserve(n_native_args);
     for (int i = 0; i < n_native_args; i++) {
-        auto arg_info = GIRInfoUniquePtr(g_callable_info_get_arg(gir_closure->callable_info.get(), i));
+        auto arg_info = GIRInfoUniquePtr(g_callable_info_get_arg(callable_info, i));
         auto arg_type_info = GIRInfoUniquePtr(g_arg_info_get_type(arg_info.get()));
         if (g_type_info_get_tag(arg_type_info.get()) == GI_TYPE_TAG_VOID) {
-            // skip void arguments
-            continue;
+            arg_type_info = nullptr;
         }
-        js_args.push_back(Args::from_g_type(gi_args[i], arg_type_info.get(), 0));
+        trampoline->arg_type_infos.push_back(move(arg_type_info));
     }
-    Local<Function> js_callback = Nan::New<Function>(gir_closure->callback);
-    Nan::Call(js_callback, Nan::GetCurrentContext()->Global(), js_args.size(), js_args.data());
+    trampoline->return_type_info = GIRInfoUniquePtr(g_callable_info_get_return_type(callable_info));
 }
 
-ffi_closure *GIRClosure::create_ffi(GICallableInfo *callable_info, Local<Function> js_callback) {
-    ffi_cif *cif = new ffi_cif(); // FIXME: where do we free this
-    GClosure *gclosure = GIRClosure::create(callable_info, js_callback);
-    return g_callable_info_prepare_closure(callable_info, cif, GIRClosure::ffi_closure_callback, gclosure);
+/**
+ * unbinds a trampoline from it's JS function (releasing the closure) and puts
+ * it back in it's pool. It has the signature of a GDestroyNotify so it can be
+ * given to native code as a notified callback's destroy function.
+ * Pooled trampolines are never freed, a pool only grows to the number of
+ * callbacks of it's signature that were in use at the same time. Unnamed
+ * callback types can't be pooled so their trampolines are freed instead, once
+ * they aren't being called.
+ */
+void GIRClosure::release_trampoline(gpointer data) {
+    FFITrampoline *trampoline = static_cast<FFITrampoline *>(data);
+    if (trampoline->closure == nullptr) {
+        return;
+    }
+    g_closure_unref(trampoline->closure);
+    trampoline->closure = nullptr;
+    if (!trampoline->signature.empty()) {
+        free_trampolines[trampoline->signature].push_back(trampoline);
+    } else if (trampoline->n_calls > 0) {
+        // libffi still needs the trampoline to return to native code
+        g_idle_add(GIRClosure::free_trampoline, trampoline);
+    } else {
+        GIRClosure::free_trampoline(trampoline);
+    }
 }
 
-void GIRClosure::closure_marshal(GClosure *closure,
-                                 GValue *return_value,
-                                 guint n_param_values,
-                                 const GValue *param_values,
-                                 gpointer invocation_hint,
-                                 gpointer marshal_data) {
-    GIRClosure *gir_signal_closure = (GIRClosure *)closure;
-    Nan::HandleScope scope;
+/**
+ * frees an unpooled trampoline's executable memory. It has the signature of a
+ * GSourceFunc so it can be deferred to the main loop.
+ */
+gboolean GIRClosure::free_trampoline(gpointer data) {
+    FFITrampoline *trampoline = static_cast<FFITrampoline *>(data);
+    g_callable_info_free_closure(trampoline->callable_info.get(), trampoline->native_closure);
+    delete trampoline;
+    return G_SOURCE_REMOVE;
+}
 
-    // create a list of JS values to be passed as arguments to the callback.
-    // the list will be created from using the param_values array.
-    vector<Local<Value>> callback_argv(n_param_values);
+/**
+ * creates a callback that calls the JS function and is never released. This
+ * is only used where there's no scope or destroy notify to tell us when native
+ * code is done with the callback (e.g. callbacks stored in struct fields or
+ * pointer arrays). Each one keeps it's trampoline, closure and JS function
+ * alive for the life of the process, so they're counted by
+ * Stats::ffi_trampolines_leaked.
+ */
+ffi_closure *GIRClosure::create_ffi(GICallableInfo *callable_info, Local<Function> js_callback) {
+    Stats::ffi_trampolines_leaked++;
+    return GIRClosure::acquire_trampoline(callable_info, js_callback, GI_SCOPE_TYPE_NOTIFIED)->native_closure;
+}
 
-    // for each value in param_values, convert to a Local<Value> using
-    // converters defined in values.h for GValue -> v8::Value conversions.
-    for (guint i = 0; i < n_param_values; i++) {
-        // then get some GI information for this argument (find it's Type)
-        // we can get this information from the original callable_info that the
-        // signal_closure was created for.
-        auto arg_info = GIRInfoUniquePtr(g_callable_info_get_arg(gir_signal_closure->callable_info.get(),
-                                                                 i)); // FIXME: CRITICAL: we should assert that the
-                                                                      // length of the callable params matches the
-                                                                      // n_param_values to avoid an array overrun!!!!!!!
-        auto type_info = GIRInfoUniquePtr(g_arg_info_get_type(arg_info.get()));
+/**
+ * converts the params of an emission to JS and calls the JS callback with them.
+ * return_value may be nullptr if there's nowhere to put the callback's result.
+ */
+void GIRClosure::call_js(const GValue *param_values, guint n_param_values, GValue *return_value) {
+    SignalPlan *plan = this->signal_plan;
 
-        // convert the native GValue to a v8::Value
-        Local<Value> js_param = GIRValue::from_g_value(&param_values[i], type_info.get());
+    // the callback may have been collected with the wrapper of the object
+    // that's being finalized (see create_for_signal)
+    if (this->callback.IsEmpty()) {
+        return;
+    }
+
+    // create a list of JS values to be passed as arguments to the callback.
+    // the list will be created from using the param_values array. Signals
+    // have few params so they go on the stack.
+    Local<Value> *callback_argv = (Local<Value> *)g_alloca(sizeof(Local<Value>) * n_param_values);
 
-        // put the value into 'argv', ready for the callback!
-        callback_argv[i] = js_param;
+    try {
+        // for each value in param_values, convert to a Local<Value> using the
+        // converter the signal's plan resolved for it. Values that don't match
+        // the plan (or closures without a plan) use the generic conversion.
+        for (guint i = 0; i < n_param_values; i++) {
+            const GValue *param_value = &param_values[i];
+            if (plan != nullptr && i < plan->n_params && plan->matches(i, G_VALUE_TYPE(param_value))) {
+                const GValueConverter *converter = plan->param_converters[i];
+                callback_argv[i] = converter->to_js(param_value, *converter);
+            } else {
+                Stats::signal_unplanned_conversions++;
+                callback_argv[i] = GIRValue::from_g_value(param_value, nullptr);
+            }
+        }
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
+        return;
     }
 
     // get a local reference to the closure's callback (a JS function)
-    Local<Function> local_callback = Nan::New<Function>(gir_signal_closure->callback);
+    Local<Function> local_callback = Nan::New<Function>(this->callback);
 
     // Call the function. We will pass 'global' as the value of 'this' inside the callback
     // Generally people should never use the value of 'this' in a callback function as it's
@@ -103,21 +422,220 @@ void GIRClosure::closure_marshal(GClosure *closure,
     Nan::MaybeLocal<Value> maybe_result = Nan::Call(local_callback,
                                                     Nan::GetCurrentContext()->Global(),
                                                     n_param_values,
-                                                    callback_argv.data());
+                                                    callback_argv);
 
-    // handle the result of the JS callback call
-    if (maybe_result.IsEmpty() || maybe_result.ToLocalChecked()->IsNull() ||
+    // handle the result of the JS callback call. If there's nothing to return
+    // (or nowhere to return it to) then the return value is left as it is.
+    if (return_value == nullptr || maybe_result.IsEmpty() || maybe_result.ToLocalChecked()->IsNull() ||
         maybe_result.ToLocalChecked()->IsUndefined()) {
-        // we don't have a return value
-        return_value = nullptr; // set the signal return value to NULL
         return;
-    } else {
-        // we have a return value
-        Local<Value> result = maybe_result.ToLocalChecked();
-        GValue g_value = GIRValue::to_g_value(result, G_VALUE_TYPE(return_value));
-        g_value_copy(&g_value, return_value);
+    }
+
+    // GSignal has already initialized the return value with the signal's return type
+    Local<Value> result = maybe_result.ToLocalChecked();
+    try {
+        if (plan != nullptr && plan->return_converter != nullptr && G_VALUE_TYPE(return_value) == plan->return_type) {
+            plan->return_converter->from_js(return_value, result, *plan->return_converter);
+        } else {
+            GValue g_value = GIRValue::to_g_value(result, G_VALUE_TYPE(return_value));
+            g_value_copy(&g_value, return_value);
+            g_value_unset(&g_value);
+        }
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
+    }
+}
+
+void GIRClosure::closure_marshal(GClosure *closure,
+                                 GValue *return_value,
+                                 guint n_param_values,
+                                 const GValue *param_values,
+                                 gpointer invocation_hint,
+                                 gpointer marshal_data) {
+    GIRClosure *gir_closure = (GIRClosure *)closure;
+    SignalOptions *options = gir_closure->signal_options;
+
+    if (options != nullptr && !options->filter.is_empty() &&
+        !options->filter.matches(param_values, n_param_values, (GSignalInvocationHint *)invocation_hint)) {
+        return;
+    }
+
+    // once-only handlers disconnect before calling into JS so that an emission
+    // caused by the callback can't call it again. GSignal holds a reference to
+    // the closure while it's being invoked so it isn't finalized until we return.
+    if (options != nullptr && options->once && gir_closure->handler_id != 0) {
+        GObject *instance = (GObject *)g_value_peek_pointer(&param_values[0]);
+        g_signal_handler_disconnect(instance, gir_closure->handler_id);
+        GIRObject::forget_signal_handler(instance, gir_closure->handler_id);
+        gir_closure->handler_id = 0;
+    }
+
+    // coalesced signals don't call into JS now, the emission is delivered later
+    if (options != nullptr && options->coalesce != SignalCoalesce::NONE) {
+        gir_closure->queue_emission(param_values, n_param_values);
+        return;
+    }
+
+    Nan::HandleScope scope;
+    gir_closure->call_js(param_values, n_param_values, return_value);
+}
+
+/**
+ * keeps a copy of an emission's params (replacing any older emission that's
+ * still waiting) and makes sure there's a main loop source to deliver them.
+ * Coalesced signals can't return a value (GIRObject::connect checks this).
+ */
+void GIRClosure::queue_emission(const GValue *param_values, guint n_param_values) {
+    this->clear_pending_values();
+    this->pending_values = g_new0(GValue, n_param_values);
+    this->n_pending_values = n_param_values;
+    for (guint i = 0; i < n_param_values; i++) {
+        g_value_init(&this->pending_values[i], G_VALUE_TYPE(&param_values[i]));
+        g_value_copy(&param_values[i], &this->pending_values[i]);
+    }
+
+    if (this->pending_source != 0) {
         return;
     }
+    if (this->signal_options->coalesce == SignalCoalesce::FRAME) {
+        // GTK redraws at G_PRIORITY_HIGH_IDLE + 20 so this runs once per
+        // main loop iteration, after event processing and before drawing.
+        this->pending_source = g_idle_add_full(G_PRIORITY_HIGH_IDLE + 10,
+                                               GIRClosure::deliver_pending_emission,
+                                               this,
+                                               nullptr);
+    } else {
+        this->pending_source = g_timeout_add_full(G_PRIORITY_DEFAULT,
+                                                  this->signal_options->coalesce_interval,
+                                                  GIRClosure::deliver_pending_emission,
+                                                  this,
+                                                  nullptr);
+    }
+}
+
+void GIRClosure::clear_pending_values() {
+    for (guint i = 0; i < this->n_pending_values; i++) {
+        g_value_unset(&this->pending_values[i]);
+    }
+    g_free(this->pending_values);
+    this->pending_values = nullptr;
+    this->n_pending_values = 0;
+}
+
+gboolean GIRClosure::deliver_pending_emission(gpointer user_data) {
+    GIRClosure *gir_closure = static_cast<GIRClosure *>(user_data);
+    gir_closure->pending_source = 0;
+
+    // the callback could emit the signal again (queueing a new emission) or
+    // disconnect it (finalizing the closure) so we hold on to both until we're done.
+    GValue *values = gir_closure->pending_values;
+    guint n_values = gir_closure->n_pending_values;
+    gir_closure->pending_values = nullptr;
+    gir_closure->n_pending_values = 0;
+    g_closure_ref(&gir_closure->closure);
+
+    {
+        Nan::HandleScope scope;
+        gir_closure->call_js(values, n_values, nullptr);
+    }
+
+    for (guint i = 0; i < n_values; i++) {
+        g_value_unset(&values[i]);
+    }
+    g_free(values);
+    g_closure_unref(&gir_closure->closure);
+    return FALSE;
+}
+
+bool SignalFilter::is_empty() const {
+    return this->details.empty() && this->params.empty();
+}
+
+bool SignalFilter::matches(const GValue *param_values, guint n_param_values, GSignalInvocationHint *hint) const {
+    if (!this->details.empty()) {
+        GQuark detail = hint != nullptr ? hint->detail : 0;
+        if (find(this->details.begin(), this->details.end(), detail) == this->details.end()) {
+            return false;
+        }
+    }
+
+    for (const SignalParamFilter &param_filter : this->params) {
+        gint64 value;
+        if (param_filter.index >= n_param_values ||
+            !SignalFilter::get_integer(&param_values[param_filter.index], &value)) {
+            return false;
+        }
+        if (find(param_filter.values.begin(), param_filter.values.end(), value) == param_filter.values.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * returns true if values of the given type can be filtered on (see get_integer)
+ */
+bool SignalFilter::is_integer_type(GType type) {
+    switch (G_TYPE_FUNDAMENTAL(type)) {
+        case G_TYPE_BOOLEAN:
+        case G_TYPE_CHAR:
+        case G_TYPE_UCHAR:
+        case G_TYPE_INT:
+        case G_TYPE_UINT:
+        case G_TYPE_LONG:
+        case G_TYPE_ULONG:
+        case G_TYPE_INT64:
+        case G_TYPE_UINT64:
+        case G_TYPE_ENUM:
+        case G_TYPE_FLAGS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * reads a GValue that holds an integer (of any size), enum, flags or boolean.
+ * returns false if the value holds any other type.
+ */
+bool SignalFilter::get_integer(const GValue *value, gint64 *integer) {
+    switch (G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(value))) {
+        case G_TYPE_BOOLEAN:
+            *integer = g_value_get_boolean(value);
+            return true;
+        case G_TYPE_CHAR:
+            *integer = g_value_get_schar(value);
+            return true;
+        case G_TYPE_UCHAR:
+            *integer = g_value_get_uchar(value);
+            return true;
+        case G_TYPE_INT:
+            *integer = g_value_get_int(value);
+            return true;
+        case G_TYPE_UINT:
+            *integer = g_value_get_uint(value);
+            return true;
+        case G_TYPE_LONG:
+            *integer = g_value_get_long(value);
+            return true;
+        case G_TYPE_ULONG:
+            *integer = g_value_get_ulong(value);
+            return true;
+        case G_TYPE_INT64:
+            *integer = g_value_get_int64(value);
+            return true;
+        case G_TYPE_UINT64:
+            *integer = g_value_get_uint64(value);
+            return true;
+        case G_TYPE_ENUM:
+            *integer = g_value_get_enum(value);
+            return true;
+        case G_TYPE_FLAGS:
+            *integer = g_value_get_flags(value);
+            return true;
+        default:
+            return false;
+    }
 }
 
 /**
@@ -129,7 +647,19 @@ void GIRClosure::finalize_handler(gpointer notify_data, GClosure *closure) {
     GIRClosure *gir_signal_closure = (GIRClosure *)closure;
 
     // unref (free) the GI callable_info
-    g_base_info_unref(gir_signal_closure->callable_info.get());
+    if (gir_signal_closure->callable_info != nullptr) {
+        g_base_info_unref(gir_signal_closure->callable_info.get());
+    }
+
+    // drop any emission that hasn't been delivered yet
+    if (gir_signal_closure->pending_source != 0) {
+        g_source_remove(gir_signal_closure->pending_source);
+        gir_signal_closure->pending_source = 0;
+    }
+    gir_signal_closure->clear_pending_values();
+
+    delete gir_signal_closure->signal_options;
+    gir_signal_closure->signal_options = nullptr;
 
     // reset (free) the JS persistent function
     gir_signal_closure->callback.Reset();
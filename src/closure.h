@@ -6,8 +6,10 @@
 #include <nan.h>
 #include <node.h>
 #include <string>
+#include <vector>
 #include "types/object.h"
 #include "util.h"
+#include "values.h"
 
 namespace gir {
 
@@ -16,19 +18,125 @@ using namespace v8;
 
 using PersistentFunction = Nan::Persistent<Function, CopyablePersistentTraits<Function>>;
 
+/**
+ * Everything closure_marshal needs to convert a signal's parameters and return
+ * value. A plan is built from the signal's GSignalQuery the first time the
+ * signal is connected to and it's shared by every closure connected to it.
+ */
+struct SignalPlan {
+    // the number of params including the instance, which is always param 0
+    guint n_params;
+    vector<GType> param_types;
+    vector<const GValueConverter *> param_converters;
+    GType return_type;
+    const GValueConverter *return_converter; // nullptr if the signal doesn't return a value
+
+    static SignalPlan *get(guint signal_id);
+    bool matches(guint index, GType g_type) const;
+};
+
+/**
+ * How a signal's emissions are delivered to JS
+ */
+enum class SignalCoalesce {
+    NONE,     // every emission calls the JS callback synchronously
+    FRAME,    // only the latest emission is delivered, once per main loop iteration
+    INTERVAL, // only the latest emission is delivered, at most once per interval
+};
+
+/**
+ * Matches one of an emission's integer (or enum, flags, boolean) params against
+ * a list of values. index is the param's position, 0 is the instance.
+ */
+struct SignalParamFilter {
+    guint index;
+    vector<gint64> values;
+};
+
+/**
+ * Decides whether an emission should be delivered to JS at all. It's checked
+ * before any of the emission's params are converted, so emissions that don't
+ * match never enter JS.
+ */
+struct SignalFilter {
+    vector<GQuark> details; // empty means any detail matches
+    vector<SignalParamFilter> params;
+
+    bool is_empty() const;
+    bool matches(const GValue *param_values, guint n_param_values, GSignalInvocationHint *hint) const;
+    static bool get_integer(const GValue *value, gint64 *integer);
+    static bool is_integer_type(GType type);
+};
+
+/**
+ * The options JS can give when connecting to a signal (see GIRObject::connect)
+ */
+struct SignalOptions {
+    SignalCoalesce coalesce = SignalCoalesce::NONE;
+    guint coalesce_interval = 0; // in milliseconds, only used for SignalCoalesce::INTERVAL
+    SignalFilter filter;
+    bool after = false; // run the handler after the signal's default handler
+    bool once = false;  // disconnect the handler when it's first called
+    string group;       // the handler's group for disconnectAll(), empty if it's not in one
+};
+
+/**
+ * A libffi trampoline that native code can call as a callback of a given
+ * signature, which calls into the JS function of the closure it's bound to.
+ * Preparing a trampoline allocates executable memory so released trampolines
+ * are kept in a pool (by signature) and re-bound to the next JS function,
+ * except those of unnamed callback types which are freed.
+ * Trampolines are heap allocated once and never move because the prepared
+ * ffi_closure points to their cif.
+ */
+struct FFITrampoline {
+    ffi_cif cif;
+    ffi_closure *native_closure;
+    GIRInfoUniquePtr callable_info;
+    string signature;  // the key of the trampoline's pool, empty if it can't be pooled
+    GIScopeType scope; // the scope it was acquired with
+    GClosure *closure; // the closure the trampoline is bound to, nullptr while it's in the pool
+    guint n_calls;     // the number of calls through the trampoline that haven't returned yet
+
+    // loaded once when the trampoline is prepared (see load_trampoline_types)
+    vector<GIRInfoUniquePtr> arg_type_infos; // nullptr for arguments that aren't passed to JS
+    GIRInfoUniquePtr return_type_info;
+};
+
 class GIRClosure {
 private:
     GClosure closure;
-    GIRInfoUniquePtr callable_info;
+    GIRInfoUniquePtr callable_info; // only set for closures created by create()
+    SignalPlan *signal_plan;        // only set for closures created by create_for_signal()
+    SignalOptions *signal_options;  // only set for closures created by create_for_signal()
+    gulong handler_id;              // the id the closure was connected with (see set_handler_id)
     PersistentFunction callback;
 
+    // the latest emission's params that are waiting to be delivered to JS (for
+    // coalesced signals) and the main loop source that will deliver them.
+    GValue *pending_values;
+    guint n_pending_values;
+    guint pending_source;
+
 public:
     static GClosure *create(GICallableInfo *callable_info, Local<Function> callback);
+    static GClosure *create_for_signal(guint signal_id, Local<Function> callback, const SignalOptions &options);
+
+    static void set_handler_id(GClosure *closure, gulong handler_id);
 
     static ffi_closure *create_ffi(GICallableInfo *callable_info, Local<Function> callback);
+    static FFITrampoline *acquire_trampoline(GICallableInfo *callable_info,
+                                             Local<Function> callback,
+                                             GIScopeType scope);
+    static void release_trampoline(gpointer trampoline);
 
 private:
     GIRClosure() = default;
+    static GIRClosure *create_closure(Local<Function> callback);
+    void call_js(const GValue *param_values, guint n_param_values, GValue *return_value);
+    void queue_emission(const GValue *param_values, guint n_param_values);
+    void clear_pending_values();
+    static gboolean deliver_pending_emission(gpointer user_data);
     static void closure_marshal(GClosure *closure,
                                 GValue *return_value,
                                 guint n_param_values,
@@ -39,6 +147,11 @@ private:
     static void finalize_handler(gpointer notify_data, GClosure *closure);
 
     static void ffi_closure_callback(ffi_cif *cif, void *result, void **args, gpointer user_data);
+    static void call_js_callback(FFITrampoline *trampoline, GIRClosure *gir_closure, void *result, void **args);
+    static void store_ffi_return_value(GITypeInfo *return_type_info, Local<Value> js_result, void *result);
+    static string get_signature(GICallableInfo *callable_info);
+    static void load_trampoline_types(FFITrampoline *trampoline);
+    static gboolean free_trampoline(gpointer trampoline);
 };
 
 } // namespace gir
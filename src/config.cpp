@@ -0,0 +1,46 @@
+#include "config.h"
+#include "int64.h"
+
+using namespace v8;
+
+namespace gir {
+
+namespace Config {
+
+bool lazy_lists = false;
+bool bigint = false;
+
+} // namespace Config
+
+/**
+ * configure({ lazyLists: boolean, bigint: boolean })
+ * Options that aren't given keep their current value. Returns the
+ * options that are now in effect.
+ */
+NAN_METHOD(configure) {
+    if (info.Length() > 0 && info[0]->IsObject()) {
+        Local<Object> options = info[0]->ToObject();
+        Local<Value> lazy_lists = Nan::Get(options, Nan::New("lazyLists").ToLocalChecked()).ToLocalChecked();
+        if (!lazy_lists->IsUndefined()) {
+            Config::lazy_lists = lazy_lists->BooleanValue();
+        }
+        Local<Value> bigint = Nan::Get(options, Nan::New("bigint").ToLocalChecked()).ToLocalChecked();
+        if (!bigint->IsUndefined()) {
+            if (bigint->BooleanValue() && !NODE_GIR_HAVE_BIGINT) {
+                Nan::ThrowError("the bigint option requires a version of node that supports BigInt");
+                return;
+            }
+            Config::bigint = bigint->BooleanValue();
+        }
+    } else if (info.Length() > 0 && !info[0]->IsUndefined()) {
+        Nan::ThrowTypeError("configure() expects an options object");
+        return;
+    }
+
+    Local<Object> current = Nan::New<Object>();
+    Nan::Set(current, Nan::New("lazyLists").ToLocalChecked(), Nan::New<Boolean>(Config::lazy_lists));
+    Nan::Set(current, Nan::New("bigint").ToLocalChecked(), Nan::New<Boolean>(Config::bigint));
+    info.GetReturnValue().Set(current);
+}
+
+} // namespace gir
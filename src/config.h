@@ -0,0 +1,26 @@
+#pragma once
+
+#include <nan.h>
+
+namespace gir {
+
+/**
+ * Global options that change how values are converted between JS and native.
+ * They're set from JS with the native module's configure() function and
+ * apply to every namespace that's been (or will be) loaded.
+ */
+namespace Config {
+
+// if true, GLists and GSLists returned from native functions are converted
+// to a lazy iterable (see GIRListIterator) instead of a JS array.
+extern bool lazy_lists;
+
+// if true, 64 bit integers that don't fit in a Number are converted
+// to a BigInt (see Int64).
+extern bool bigint;
+
+} // namespace Config
+
+NAN_METHOD(configure);
+
+} // namespace gir
@@ -1,7 +1,8 @@
-const { load } = require('./addon');
+const { load, configure } = require('./addon');
 
 module.exports = {
   load,
+  configure,
   get GLib() {
     return require('./GLib');
   },
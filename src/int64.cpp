@@ -0,0 +1,63 @@
+#include "int64.h"
+#include "config.h"
+#include "exceptions.h"
+
+namespace gir {
+
+namespace Int64 {
+
+Local<Value> from_int64(gint64 value) {
+#if NODE_GIR_HAVE_BIGINT
+    if (Config::bigint && (value > max_safe_integer || value < -max_safe_integer)) {
+        return BigInt::New(Isolate::GetCurrent(), value);
+    }
+#endif
+    return Nan::New<Number>(static_cast<double>(value));
+}
+
+Local<Value> from_uint64(guint64 value) {
+#if NODE_GIR_HAVE_BIGINT
+    if (Config::bigint && value > (guint64)max_safe_integer) {
+        return BigInt::NewFromUnsigned(Isolate::GetCurrent(), value);
+    }
+#endif
+    return Nan::New<Number>(static_cast<double>(value));
+}
+
+gint64 to_int64(Local<Value> js_value) {
+#if NODE_GIR_HAVE_BIGINT
+    if (js_value->IsBigInt()) {
+        bool lossless;
+        gint64 value = Local<BigInt>::Cast(js_value)->Int64Value(&lossless);
+        if (!lossless) {
+            throw JSArgumentTypeError("BigInt is too large for a 64 bit integer");
+        }
+        return value;
+    }
+#endif
+    return js_value->IntegerValue();
+}
+
+guint64 to_uint64(Local<Value> js_value) {
+#if NODE_GIR_HAVE_BIGINT
+    if (js_value->IsBigInt()) {
+        bool lossless;
+        guint64 value = Local<BigInt>::Cast(js_value)->Uint64Value(&lossless);
+        if (!lossless) {
+            throw JSArgumentTypeError("BigInt is too large for an unsigned 64 bit integer");
+        }
+        return value;
+    }
+#endif
+    // IntegerValue() saturates at the largest signed value so numbers
+    // beyond that are converted directly.
+    double number = js_value->NumberValue();
+    if (number >= 9223372036854775808.0) {
+        return static_cast<guint64>(number);
+    }
+    return static_cast<guint64>(js_value->IntegerValue());
+}
+
+} // namespace Int64
+
+} // namespace gir
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glib.h>
+#include <nan.h>
+#include <v8.h>
+
+// BigInt (and BigInt64Array) were added to the V8 API in V8 6.8 (node 10.4)
+#if V8_MAJOR_VERSION > 6 || (V8_MAJOR_VERSION == 6 && V8_MINOR_VERSION >= 8)
+#define NODE_GIR_HAVE_BIGINT 1
+#else
+#define NODE_GIR_HAVE_BIGINT 0
+#endif
+
+namespace gir {
+
+using namespace v8;
+
+/**
+ * Conversions for 64 bit integers. JS Numbers can only hold integers of up to
+ * 53 bits exactly, so when the bigint option is set (see configure()) larger
+ * values are converted to a BigInt. Values that fit in a Number are still
+ * returned as a Number because that's what most callers expect and it's faster.
+ * BigInts are always accepted from JS (if the runtime supports them).
+ */
+namespace Int64 {
+
+// the largest integer a double can hold without losing precision (2^53 - 1)
+const gint64 max_safe_integer = G_GINT64_CONSTANT(9007199254740991);
+
+Local<Value> from_int64(gint64 value);
+Local<Value> from_uint64(guint64 value);
+
+// these throw a JSArgumentTypeError if a BigInt doesn't fit in the native type
+gint64 to_int64(Local<Value> js_value);
+guint64 to_uint64(Local<Value> js_value);
+
+} // namespace Int64
+
+} // namespace gir
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "SmallVector.h"
+
+namespace gir {
+
+/**
+ * A bump allocator for memory that only needs to live for the duration of a single
+ * native call, such as converted string arguments or temporary GValues.
+ *
+ * Allocations are served from a small block inside the arena itself and only go
+ * to the heap once that's used up. Nothing is freed individually, instead reset()
+ * (or the destructor) runs any deferred cleanups and releases everything at once.
+ */
+class ScratchArena {
+public:
+    using Cleanup = void (*)(void *);
+
+    // the number of times any ScratchArena has had to allocate a heap block.
+    // This is useful for benchmarking (see Stats).
+    static size_t heap_allocations;
+
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena &operator=(const ScratchArena &) = delete;
+
+    ~ScratchArena() {
+        this->reset();
+    }
+
+    /**
+     * returns size bytes of uninitialized memory
+     */
+    void *alloc(size_t size) {
+        size = ScratchArena::align(size);
+        if (this->used + size > this->block_size) {
+            this->grow(size);
+        }
+        void *memory = this->block + this->used;
+        this->used += size;
+        return memory;
+    }
+
+    /**
+     * returns size bytes of zeroed memory
+     */
+    void *alloc0(size_t size) {
+        void *memory = this->alloc(size);
+        memset(memory, 0, size);
+        return memory;
+    }
+
+    /**
+     * copies length bytes of string into the arena and null terminates it
+     */
+    char *copy_string(const char *string, size_t length) {
+        char *copy = static_cast<char *>(this->alloc(length + 1));
+        memcpy(copy, string, length);
+        copy[length] = '\0';
+        return copy;
+    }
+
+    /**
+     * registers a function to be called with data when the arena is reset.
+     * cleanups are run in the reverse order to which they were deferred.
+     */
+    void defer(Cleanup cleanup, void *data) {
+        this->cleanups.push_back(DeferredCleanup{cleanup, data});
+    }
+
+    void reset() {
+        for (size_t i = this->cleanups.size(); i > 0; i--) {
+            DeferredCleanup &deferred = this->cleanups[i - 1];
+            deferred.cleanup(deferred.data);
+        }
+        this->cleanups.clear();
+
+        while (this->heap_blocks != nullptr) {
+            HeapBlock *next = this->heap_blocks->next;
+            free(this->heap_blocks);
+            this->heap_blocks = next;
+        }
+
+        this->block = this->inline_block;
+        this->block_size = sizeof(this->inline_block);
+        this->used = 0;
+    }
+
+private:
+    static const size_t alignment = 16;
+    static const size_t inline_size = 512;
+    static const size_t heap_block_size = 4096;
+
+    struct DeferredCleanup {
+        Cleanup cleanup;
+        void *data;
+    };
+
+    struct HeapBlock {
+        HeapBlock *next;
+        size_t padding; // keeps the block's memory (which follows the header) aligned
+    };
+
+    alignas(alignment) char inline_block[inline_size];
+    char *block = inline_block;
+    size_t block_size = inline_size;
+    size_t used = 0;
+    HeapBlock *heap_blocks = nullptr;
+    SmallVector<DeferredCleanup, 8> cleanups;
+
+    static size_t align(size_t size) {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    void grow(size_t minimum_size) {
+        size_t size = heap_block_size;
+        if (minimum_size > size) {
+            size = minimum_size;
+        }
+        HeapBlock *heap_block = static_cast<HeapBlock *>(malloc(sizeof(HeapBlock) + size));
+        if (heap_block == nullptr) {
+            throw std::bad_alloc();
+        }
+        heap_block->next = this->heap_blocks;
+        this->heap_blocks = heap_block;
+        this->block = reinterpret_cast<char *>(heap_block + 1);
+        this->block_size = size;
+        this->used = 0;
+        ScratchArena::heap_allocations++;
+    }
+};
+
+} // namespace gir
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace gir {
+
+/**
+ * A vector that keeps it's first InlineCapacity elements inside the object itself
+ * and only falls back to the heap when it grows beyond that. When a SmallVector
+ * lives on the stack this means the common case never allocates.
+ *
+ * Elements are moved around with memcpy and are never destructed, so this is only
+ * suitable for plain-old-data types such as GIArgument or raw pointers.
+ */
+template<class T, size_t InlineCapacity>
+class SmallVector {
+public:
+    // the number of times any SmallVector of this type has had to move it's
+    // elements to the heap. This is useful for benchmarking (see Stats).
+    static size_t heap_allocations;
+
+    SmallVector() = default;
+    SmallVector(const SmallVector &) = delete;
+    SmallVector &operator=(const SmallVector &) = delete;
+
+    ~SmallVector() {
+        if (!this->is_inline()) {
+            free(this->elements);
+        }
+    }
+
+    T *data() {
+        return this->elements;
+    }
+
+    size_t size() const {
+        return this->length;
+    }
+
+    bool empty() const {
+        return this->length == 0;
+    }
+
+    bool is_inline() const {
+        return this->elements == this->inline_elements;
+    }
+
+    T *begin() {
+        return this->elements;
+    }
+
+    T *end() {
+        return this->elements + this->length;
+    }
+
+    T &operator[](size_t index) {
+        return this->elements[index];
+    }
+
+    void push_back(const T &value) {
+        if (this->length == this->capacity) {
+            this->reserve(this->capacity * 2);
+        }
+        this->elements[this->length++] = value;
+    }
+
+    /**
+     * resizing the vector value-initializes (zeroes) any new elements
+     */
+    void resize(size_t new_length) {
+        this->reserve(new_length);
+        for (size_t i = this->length; i < new_length; i++) {
+            this->elements[i] = T();
+        }
+        this->length = new_length;
+    }
+
+    void clear() {
+        this->length = 0;
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= this->capacity) {
+            return;
+        }
+        T *new_elements = static_cast<T *>(malloc(sizeof(T) * new_capacity));
+        if (new_elements == nullptr) {
+            throw std::bad_alloc();
+        }
+        memcpy(new_elements, this->elements, sizeof(T) * this->length);
+        if (!this->is_inline()) {
+            free(this->elements);
+        } else {
+            SmallVector::heap_allocations++;
+        }
+        this->elements = new_elements;
+        this->capacity = new_capacity;
+    }
+
+private:
+    T inline_elements[InlineCapacity];
+    T *elements = inline_elements;
+    size_t length = 0;
+    size_t capacity = InlineCapacity;
+};
+
+template<class T, size_t InlineCapacity>
+size_t SmallVector<T, InlineCapacity>::heap_allocations = 0;
+
+} // namespace gir
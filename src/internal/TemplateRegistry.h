@@ -0,0 +1,74 @@
+#pragma once
+
+#include <girepository.h>
+#include <glib-object.h>
+#include <nan.h>
+#include <string>
+#include <unordered_map>
+
+namespace gir {
+
+using PersistentFunctionTemplate =
+        Nan::Persistent<v8::FunctionTemplate, v8::CopyablePersistentTraits<v8::FunctionTemplate>>;
+
+struct ObjectFunctionTemplate {
+    char *type_name;
+    GIBaseInfo *info; // FIXME: use GIRInfoUniquePtr
+    PersistentFunctionTemplate object_template;
+    GType type;
+    char *namespace_;
+};
+
+/**
+ * The registry of every JS class (FunctionTemplate) we've created for a
+ * registered type. It's shared by objects, interfaces and structs so a type's
+ * template can be found in constant time no matter how many have been created.
+ *
+ * Templates are keyed by their GType. Some types (such as plain C structs)
+ * aren't registered with the GType system so they are all G_TYPE_NONE, these
+ * are keyed by their canonical "Namespace.Name" instead.
+ *
+ * Templates live for as long as the process does, so the registry never
+ * frees them.
+ */
+class TemplateRegistry {
+public:
+    static ObjectFunctionTemplate *find(GIRegisteredTypeInfo *info) {
+        GType type = g_registered_type_info_get_g_type(info);
+        if (TemplateRegistry::has_g_type(type)) {
+            auto found = TemplateRegistry::by_g_type().find(type);
+            return found == TemplateRegistry::by_g_type().end() ? nullptr : found->second;
+        }
+        auto found = TemplateRegistry::by_name().find(TemplateRegistry::name_key(info));
+        return found == TemplateRegistry::by_name().end() ? nullptr : found->second;
+    }
+
+    static void insert(ObjectFunctionTemplate *oft) {
+        if (TemplateRegistry::has_g_type(oft->type)) {
+            TemplateRegistry::by_g_type()[oft->type] = oft;
+        } else {
+            TemplateRegistry::by_name()[TemplateRegistry::name_key(oft->info)] = oft;
+        }
+    }
+
+private:
+    static bool has_g_type(GType type) {
+        return type != G_TYPE_NONE && type != G_TYPE_INVALID;
+    }
+
+    static std::string name_key(GIBaseInfo *info) {
+        return std::string(g_base_info_get_namespace(info)) + "." + g_base_info_get_name(info);
+    }
+
+    static std::unordered_map<GType, ObjectFunctionTemplate *> &by_g_type() {
+        static std::unordered_map<GType, ObjectFunctionTemplate *> templates;
+        return templates;
+    }
+
+    static std::unordered_map<std::string, ObjectFunctionTemplate *> &by_name() {
+        static std::unordered_map<std::string, ObjectFunctionTemplate *> templates;
+        return templates;
+    }
+};
+
+} // namespace gir
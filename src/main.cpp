@@ -1,8 +1,10 @@
 #include <node.h>
 #include <v8.h>
 
+#include "config.h"
 #include "loop.h"
 #include "namespace_loader.h"
+#include "stats.h"
 
 NAN_MODULE_INIT(InitAll) {
     Nan::Set(target,
@@ -11,6 +13,15 @@ NAN_MODULE_INIT(InitAll) {
     Nan::Set(target,
              Nan::New("startLoop").ToLocalChecked(),
              Nan::GetFunction(Nan::New<v8::FunctionTemplate>(gir::start_loop)).ToLocalChecked());
+    Nan::Set(target,
+             Nan::New("configure").ToLocalChecked(),
+             Nan::GetFunction(Nan::New<v8::FunctionTemplate>(gir::configure)).ToLocalChecked());
+    Nan::Set(target,
+             Nan::New("getStats").ToLocalChecked(),
+             Nan::GetFunction(Nan::New<v8::FunctionTemplate>(gir::get_stats)).ToLocalChecked());
+    Nan::Set(target,
+             Nan::New("resetStats").ToLocalChecked(),
+             Nan::GetFunction(Nan::New<v8::FunctionTemplate>(gir::reset_stats)).ToLocalChecked());
 }
 
 NODE_MODULE(girepository, InitAll)
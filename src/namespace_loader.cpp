@@ -1,9 +1,11 @@
 #include "namespace_loader.h"
+#include "stats.h"
 #include "types/enum.h"
 #include "types/function.h"
 #include "types/object.h"
 #include "types/struct.h"
 #include "util.h"
+#include "values.h"
 
 #include <cstring>
 
@@ -11,6 +13,12 @@ namespace gir {
 
 using namespace std;
 
+/**
+ * load(namespace, [version], [options])
+ * options:
+ * - lazy: when true, the namespace's classes, functions and enums are only
+ *   built the first time they're accessed on the returned module object.
+ */
 NAN_METHOD(NamespaceLoader::load) {
     if (info.Length() < 1) {
         Nan::ThrowError("too few arguments");
@@ -18,81 +26,165 @@ NAN_METHOD(NamespaceLoader::load) {
     if (!info[0]->IsString()) {
         Nan::ThrowError("argument has to be a string");
     }
+
+    bool lazy = false;
+    Local<Value> js_options = info[info.Length() - 1];
+    if (info.Length() > 1 && js_options->IsObject()) {
+        Local<Value> js_lazy = Nan::Get(js_options->ToObject(), Nan::New("lazy").ToLocalChecked()).ToLocalChecked();
+        lazy = js_lazy->BooleanValue();
+    }
+
     Local<Value> exports;
     String::Utf8Value library_namespace(info[0]);
     if (info.Length() > 1 && info[1]->IsString()) {
         String::Utf8Value version(info[1]);
-        exports = NamespaceLoader::load_namespace(*library_namespace, *version);
+        exports = NamespaceLoader::load_namespace(*library_namespace, *version, lazy);
     } else {
-        exports = NamespaceLoader::load_namespace(*library_namespace, nullptr);
+        exports = NamespaceLoader::load_namespace(*library_namespace, nullptr, lazy);
     }
     info.GetReturnValue().Set(exports);
 }
 
-Local<Value> NamespaceLoader::load_namespace(const char *library_namespace, const char *version) {
+Local<Value> NamespaceLoader::load_namespace(const char *library_namespace, const char *version, bool lazy) {
     auto repository = g_irepository_get_default();
     GError *error = nullptr;
+    gint64 require_start = g_get_monotonic_time();
     g_irepository_require(repository, library_namespace, version, (GIRepositoryLoadFlags)0, &error);
+    Stats::require_us += g_get_monotonic_time() - require_start;
     if (error != nullptr) {
         Nan::ThrowError(error->message);
         g_error_free(error);
         return Nan::Undefined();
     }
+    // values converted before this namespace was loaded may have types from it
+    GIRValue::refresh_converters();
+    if (lazy) {
+        return NamespaceLoader::build_lazy_exports(library_namespace);
+    }
     return NamespaceLoader::build_exports(library_namespace);
 }
 
 Local<Value> NamespaceLoader::build_exports(const char *library_namespace) {
     auto repository = g_irepository_get_default();
     Local<Object> module = Nan::New<Object>();
-    Local<Value> exported_value = Nan::Null();
 
     int length = g_irepository_get_n_infos(repository, library_namespace);
     for (int i = 0; i < length; i++) {
         auto info = GIRInfoUniquePtr(g_irepository_get_info(repository, library_namespace, i));
-
-        switch (g_base_info_get_type(info.get())) {
-            case GI_INFO_TYPE_OBJECT:
-                exported_value = GIRObject::prepare(info.get());
-                break;
-            case GI_INFO_TYPE_FUNCTION:
-                exported_value = GIRFunction::prepare(info.get());
-                break;
-            case GI_INFO_TYPE_BOXED:
-            case GI_INFO_TYPE_STRUCT:
-                exported_value = GIRStruct::prepare(info.get());
-                break;
-            case GI_INFO_TYPE_ENUM:
-                exported_value = GIREnum::prepare(info.get());
-                break;
-            case GI_INFO_TYPE_FLAGS:
-                exported_value = GIREnum::prepare(info.get());
-                break;
-            case GI_INFO_TYPE_UNION:
-            case GI_INFO_TYPE_INTERFACE:
-            case GI_INFO_TYPE_INVALID:
-            case GI_INFO_TYPE_CALLBACK:
-            case GI_INFO_TYPE_CONSTANT:
-            case GI_INFO_TYPE_INVALID_0:
-            case GI_INFO_TYPE_VALUE:
-            case GI_INFO_TYPE_SIGNAL:
-            case GI_INFO_TYPE_VFUNC:
-            case GI_INFO_TYPE_PROPERTY:
-            case GI_INFO_TYPE_FIELD:
-            case GI_INFO_TYPE_ARG:
-            case GI_INFO_TYPE_TYPE:
-            case GI_INFO_TYPE_UNRESOLVED:
-                // do nothing
-                break;
-        }
-
+        Local<Value> exported_value = NamespaceLoader::prepare_export(info.get());
         if (exported_value != Nan::Null()) {
             string exported_name = Util::base_info_canonical_name(info.get());
             module->Set(Nan::New(exported_name).ToLocalChecked(), exported_value);
-            exported_value = Nan::Null();
         }
     }
 
     return module;
 }
 
+/**
+ * Builds a module object where each export is an accessor stub rather than
+ * the export itself. The first time an export is accessed it's built (see
+ * NamespaceLoader::lazy_export_getter) and the stub is replaced with the
+ * built value, so the cost of building an export is only paid for the
+ * exports that are actually used.
+ */
+Local<Value> NamespaceLoader::build_lazy_exports(const char *library_namespace) {
+    auto repository = g_irepository_get_default();
+    Local<Object> module = Nan::New<Object>();
+
+    int length = g_irepository_get_n_infos(repository, library_namespace);
+    for (int i = 0; i < length; i++) {
+        GIBaseInfo *info = g_irepository_get_info(repository, library_namespace, i);
+        if (!NamespaceLoader::is_exportable(info)) {
+            g_base_info_unref(info);
+            continue;
+        }
+        // the stub owns the info's reference. It's kept for the lifetime of
+        // the module because the stub can't tell when it's been replaced.
+        string exported_name = Util::base_info_canonical_name(info);
+        Nan::SetAccessor(module,
+                         Nan::New(exported_name).ToLocalChecked(),
+                         NamespaceLoader::lazy_export_getter,
+                         NamespaceLoader::lazy_export_setter,
+                         Nan::New<External>((void *)info));
+    }
+
+    return module;
+}
+
+NAN_GETTER(NamespaceLoader::lazy_export_getter) {
+    GIBaseInfo *base_info = (GIBaseInfo *)Local<External>::Cast(info.Data())->Value();
+    Local<Value> exported_value = NamespaceLoader::prepare_export(base_info);
+
+    // replace the stub with the real export so we don't come through here again
+    Nan::DefineOwnProperty(info.Holder(), property, exported_value);
+    info.GetReturnValue().Set(exported_value);
+}
+
+NAN_SETTER(NamespaceLoader::lazy_export_setter) {
+    // assigning to an export that hasn't been built yet just replaces the stub
+    Nan::DefineOwnProperty(info.Holder(), property, value);
+}
+
+bool NamespaceLoader::is_exportable(GIBaseInfo *info) {
+    switch (g_base_info_get_type(info)) {
+        case GI_INFO_TYPE_OBJECT:
+        case GI_INFO_TYPE_FUNCTION:
+        case GI_INFO_TYPE_BOXED:
+        case GI_INFO_TYPE_STRUCT:
+        case GI_INFO_TYPE_ENUM:
+        case GI_INFO_TYPE_FLAGS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Builds the JS value that a GIBaseInfo is exported as, or returns null
+ * if the info's type isn't something we export.
+ */
+Local<Value> NamespaceLoader::prepare_export(GIBaseInfo *info) {
+    Local<Value> exported_value = Nan::Null();
+    gint64 start = g_get_monotonic_time();
+
+    switch (g_base_info_get_type(info)) {
+        case GI_INFO_TYPE_OBJECT:
+            exported_value = GIRObject::prepare(info);
+            Stats::objects_us += g_get_monotonic_time() - start;
+            break;
+        case GI_INFO_TYPE_FUNCTION:
+            exported_value = GIRFunction::prepare(info);
+            Stats::functions_us += g_get_monotonic_time() - start;
+            break;
+        case GI_INFO_TYPE_BOXED:
+        case GI_INFO_TYPE_STRUCT:
+            exported_value = GIRStruct::prepare(info);
+            Stats::structs_us += g_get_monotonic_time() - start;
+            break;
+        case GI_INFO_TYPE_ENUM:
+        case GI_INFO_TYPE_FLAGS:
+            exported_value = GIREnum::prepare(info);
+            Stats::enums_us += g_get_monotonic_time() - start;
+            break;
+        case GI_INFO_TYPE_UNION:
+        case GI_INFO_TYPE_INTERFACE:
+        case GI_INFO_TYPE_INVALID:
+        case GI_INFO_TYPE_CALLBACK:
+        case GI_INFO_TYPE_CONSTANT:
+        case GI_INFO_TYPE_INVALID_0:
+        case GI_INFO_TYPE_VALUE:
+        case GI_INFO_TYPE_SIGNAL:
+        case GI_INFO_TYPE_VFUNC:
+        case GI_INFO_TYPE_PROPERTY:
+        case GI_INFO_TYPE_FIELD:
+        case GI_INFO_TYPE_ARG:
+        case GI_INFO_TYPE_TYPE:
+        case GI_INFO_TYPE_UNRESOLVED:
+            // do nothing
+            break;
+    }
+    return exported_value;
+}
+
 } // namespace gir
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <girepository.h>
 #include <nan.h>
 #include <v8.h>
 
@@ -12,8 +13,14 @@ public:
     static NAN_METHOD(load);
 
 private:
-    static Local<Value> load_namespace(const char *library_namespace, const char *version);
+    static Local<Value> load_namespace(const char *library_namespace, const char *version, bool lazy);
     static Local<Value> build_exports(const char *library_namespace);
+    static Local<Value> build_lazy_exports(const char *library_namespace);
+    static Local<Value> prepare_export(GIBaseInfo *info);
+    static bool is_exportable(GIBaseInfo *info);
+
+    static NAN_GETTER(lazy_export_getter);
+    static NAN_SETTER(lazy_export_setter);
 };
 
 } // namespace gir
@@ -0,0 +1,68 @@
+#include "stats.h"
+#include "arguments.h"
+
+namespace gir {
+
+namespace Stats {
+
+size_t native_calls = 0;
+size_t ffi_trampolines_prepared = 0;
+size_t ffi_trampolines_leaked = 0;
+size_t signal_unplanned_conversions = 0;
+gint64 require_us = 0;
+gint64 objects_us = 0;
+gint64 functions_us = 0;
+gint64 structs_us = 0;
+gint64 enums_us = 0;
+
+} // namespace Stats
+
+// ScratchArena is header only so it's counter is defined here
+size_t ScratchArena::heap_allocations = 0;
+
+NAN_METHOD(get_stats) {
+    Local<Object> stats = Nan::New<Object>();
+    Nan::Set(stats, Nan::New("nativeCalls").ToLocalChecked(), Nan::New<Number>(Stats::native_calls));
+    Nan::Set(stats,
+             Nan::New("argsHeapAllocations").ToLocalChecked(),
+             Nan::New<Number>(ArgumentVector::heap_allocations));
+    Nan::Set(stats,
+             Nan::New("arenaHeapAllocations").ToLocalChecked(),
+             Nan::New<Number>(ScratchArena::heap_allocations));
+    Nan::Set(stats,
+             Nan::New("ffiTrampolinesPrepared").ToLocalChecked(),
+             Nan::New<Number>(Stats::ffi_trampolines_prepared));
+    Nan::Set(stats,
+             Nan::New("ffiTrampolinesLeaked").ToLocalChecked(),
+             Nan::New<Number>(Stats::ffi_trampolines_leaked));
+    Nan::Set(stats,
+             Nan::New("signalUnplannedConversions").ToLocalChecked(),
+             Nan::New<Number>(Stats::signal_unplanned_conversions));
+
+    Local<Object> load_timings = Nan::New<Object>();
+    Nan::Set(load_timings, Nan::New("require").ToLocalChecked(), Nan::New<Number>(Stats::require_us));
+    Nan::Set(load_timings, Nan::New("objects").ToLocalChecked(), Nan::New<Number>(Stats::objects_us));
+    Nan::Set(load_timings, Nan::New("functions").ToLocalChecked(), Nan::New<Number>(Stats::functions_us));
+    Nan::Set(load_timings, Nan::New("structs").ToLocalChecked(), Nan::New<Number>(Stats::structs_us));
+    Nan::Set(load_timings, Nan::New("enums").ToLocalChecked(), Nan::New<Number>(Stats::enums_us));
+    Nan::Set(stats, Nan::New("loadTimings").ToLocalChecked(), load_timings);
+
+    info.GetReturnValue().Set(stats);
+}
+
+NAN_METHOD(reset_stats) {
+    Stats::native_calls = 0;
+    Stats::ffi_trampolines_prepared = 0;
+    Stats::ffi_trampolines_leaked = 0;
+    Stats::signal_unplanned_conversions = 0;
+    ArgumentVector::heap_allocations = 0;
+    ScratchArena::heap_allocations = 0;
+    Stats::require_us = 0;
+    Stats::objects_us = 0;
+    Stats::functions_us = 0;
+    Stats::structs_us = 0;
+    Stats::enums_us = 0;
+    info.GetReturnValue().Set(Nan::Undefined());
+}
+
+} // namespace gir
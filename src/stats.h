@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glib.h>
+#include <nan.h>
+#include <cstddef>
+
+namespace gir {
+
+/**
+ * Counters describing what the bindings are doing internally. They're exposed
+ * to JS through the native module's getStats() and resetStats() functions and
+ * are intended for benchmarks and debugging, not for general use.
+ */
+namespace Stats {
+
+// the number of native functions called through GIRFunction::call_native
+extern size_t native_calls;
+
+// the number of libffi trampolines prepared for callback arguments. Released
+// trampolines are reused so this only grows with the number in use at once.
+extern size_t ffi_trampolines_prepared;
+
+// the number of callbacks that are never released because nothing tells us
+// when native code is done with them (see GIRClosure::create_ffi)
+extern size_t ffi_trampolines_leaked;
+
+// the number of signal params that didn't match their signal's plan and were
+// converted with the generic GValue conversion (see GIRClosure::call_js)
+extern size_t signal_unplanned_conversions;
+
+// the time (in microseconds) spent in each phase of loading namespaces.
+// "require" is loading the typelib, the rest are building the namespace's
+// exports (see NamespaceLoader::prepare_export). Building an object also
+// builds it's parents so they're included in the object's time.
+extern gint64 require_us;
+extern gint64 objects_us;
+extern gint64 functions_us;
+extern gint64 structs_us;
+extern gint64 enums_us;
+
+} // namespace Stats
+
+NAN_METHOD(get_stats);
+NAN_METHOD(reset_stats);
+
+} // namespace gir
@@ -2,6 +2,7 @@
 #include "exceptions.h"
 #include "namespace_loader.h"
 #include "object.h"
+#include "stats.h"
 #include "util.h"
 
 #include <nan.h>
@@ -26,10 +27,15 @@ Local<Function> GIRFunction::prepare(GIFunctionInfo *function_info) {
     return js_function;
 }
 
+/**
+ * The JS function's data is an External holding a CallPlan for the native function.
+ * The plan is built once, here, so the type information it holds doesn't need to be
+ * looked up from the typelib every time the function is called.
+ */
 Local<FunctionTemplate> GIRFunction::create_function(GIFunctionInfo *function_info) {
-    Local<External> function_info_extern = Nan::New<External>((void *)g_base_info_ref(function_info));
+    Local<External> call_plan_extern = Nan::New<External>((void *)new CallPlan(function_info));
     Local<FunctionTemplate> function_template = Nan::New<FunctionTemplate>(GIRFunction::InvokeFunction,
-                                                                           function_info_extern);
+                                                                           call_plan_extern);
     return function_template;
 }
 
@@ -37,16 +43,16 @@ Local<FunctionTemplate> GIRFunction::create_function(GIFunctionInfo *function_in
 // that executes the native function specified by GIFunctionInfo with a given GObject
 // not just GIRObject's as is the case currently with GIRFunction::InvokeMethod!
 Local<FunctionTemplate> GIRFunction::create_method(GIFunctionInfo *function_info) {
-    Local<External> function_info_extern = Nan::New<External>((void *)g_base_info_ref(function_info));
+    Local<External> call_plan_extern = Nan::New<External>((void *)new CallPlan(function_info));
     Local<FunctionTemplate> function_template = Nan::New<FunctionTemplate>(GIRFunction::InvokeMethod,
-                                                                           function_info_extern);
+                                                                           call_plan_extern);
     return function_template;
 }
 
 NAN_METHOD(GIRFunction::InvokeFunction) {
-    Local<External> function_info_extern = Local<External>::Cast(info.Data());
-    GIFunctionInfo *function_info = (GIFunctionInfo *)function_info_extern->Value();
-    Local<Value> js_func_result = GIRFunction::call(nullptr, function_info, info);
+    Local<External> call_plan_extern = Local<External>::Cast(info.Data());
+    CallPlan *plan = (CallPlan *)call_plan_extern->Value();
+    Local<Value> js_func_result = GIRFunction::call(nullptr, *plan, info);
     info.GetReturnValue().Set(js_func_result);
 }
 
@@ -58,24 +64,30 @@ NAN_METHOD(GIRFunction::InvokeMethod) {
 
     GIRObject *that = Nan::ObjectWrap::Unwrap<GIRObject>(info.This()->ToObject());
     GObject *native_object = that->get_gobject();
-    Local<External> function_info_extern = Local<External>::Cast(info.Data());
-    GIFunctionInfo *function_info = (GIFunctionInfo *)function_info_extern->Value();
+    Local<External> call_plan_extern = Local<External>::Cast(info.Data());
+    CallPlan *plan = (CallPlan *)call_plan_extern->Value();
 
-    Local<Value> js_func_result = GIRFunction::call(native_object, function_info, info);
+    Local<Value> js_func_result = GIRFunction::call(native_object, *plan, info);
     info.GetReturnValue().Set(js_func_result);
 }
 
-GIArgument GIRFunction::call_native(GIFunctionInfo *function_info, Args &args) {
+GIArgument GIRFunction::call_native(CallPlan &plan, Args &args) {
     GIArgument return_value;
     GError *error = nullptr;
 
-    g_function_info_invoke(function_info,
-                           args.in.data(),
-                           args.in.size(),
-                           args.out.data(),
-                           args.out.size(),
-                           &return_value,
-                           &error);
+    Stats::native_calls++;
+
+    if (plan.prepare_invoker()) {
+        GIRFunction::invoke(plan, args, &return_value, &error);
+    } else {
+        g_function_info_invoke(plan.get_function_info(),
+                               args.in.data(),
+                               args.in.size(),
+                               args.out.data(),
+                               args.out.size(),
+                               &return_value,
+                               &error);
+    }
 
     if (error != nullptr) {
         string message = string(error->message);
@@ -88,16 +100,53 @@ GIArgument GIRFunction::call_native(GIFunctionInfo *function_info, Args &args) {
     return return_value;
 }
 
+/**
+ * This function calls the native function directly through libffi, using the
+ * symbol and ffi_cif that were prepared once when the call plan was built.
+ * It passes arguments using the same conventions as g_function_info_invoke()
+ * but it doesn't need to resolve the symbol, build an ffi_cif or heap allocate
+ * the argument arrays on every call.
+ */
+void GIRFunction::invoke(CallPlan &plan, Args &args, GIArgument *return_value, GError **error) {
+    // libffi wants an array of pointers to each argument's value.
+    // the plan tells us exactly how many there are so we can use the stack.
+    void **ffi_args = (void **)g_alloca(sizeof(void *) * plan.n_ffi_args);
+    int ffi_position = 0;
+
+    // for methods the instance is the first native argument and it's at the
+    // start of args.in (see Args::load_context)
+    if (plan.is_method) {
+        ffi_args[ffi_position++] = &args.in[0];
+    }
+
+    for (ArgPlan &argument : plan.args) {
+        if (argument.direction == GI_DIRECTION_OUT) {
+            ffi_args[ffi_position++] = &args.out[argument.out_index];
+        } else {
+            ffi_args[ffi_position++] = &args.in[argument.in_index];
+        }
+    }
+
+    // functions that throw take a GError** as their last argument
+    if (plan.can_throw) {
+        ffi_args[ffi_position++] = &error;
+    }
+
+    GIFFIReturnValue ffi_return_value;
+    ffi_call(&plan.invoker.cif, FFI_FN(plan.invoker.native_address), &ffi_return_value, ffi_args);
+    gi_type_info_extract_ffi_return_value(&plan.return_type_info, &ffi_return_value, return_value);
+}
+
 Local<Value> GIRFunction::call(GObject *obj,
-                               GIFunctionInfo *function_info,
+                               CallPlan &plan,
                                const Nan::FunctionCallbackInfo<v8::Value> &js_callback_info) {
     // we want to catch any errors we may encounter so we can throw them as JS
     // errors
     try {
         // create the arguments for the native function
-        Args args = Args(function_info);
+        Args args(plan);
         args.load_js_arguments(js_callback_info);
-        if (g_callable_info_is_method(function_info)) {
+        if (plan.is_method) {
             if (obj != nullptr) {
                 args.load_context(obj);
             } else {
@@ -107,12 +156,12 @@ Local<Value> GIRFunction::call(GObject *obj,
 
         // call the native function. CallNative is just a small wrapper to help with
         // handling native errors and return values.
-        GIArgument result = GIRFunction::call_native(function_info, args);
+        GIArgument result = GIRFunction::call_native(plan, args);
 
         // handle the return value that we should pass back to JS.
         // there are some rules to decide how to handle there output from the native
         // function so we'll use a helper function to handle that logic for us.
-        Local<Value> js_return_value = GIRFunction::js_return_value_from_native_call(function_info, args, result);
+        Local<Value> js_return_value = GIRFunction::js_return_value_from_native_call(plan, args, result);
         return js_return_value;
     } catch (exception &error) {
         // if any exception happens we want to translate it to a JS error and return
@@ -134,56 +183,46 @@ Local<Value> GIRFunction::call(GObject *obj,
  * - If the native function has a return value and 1 or more out-args then return them as an array with the return value
  * in position 0: [return-value, out-arg-1, out-arg-2, ..., out-arg-n]
  */
-Local<Value> GIRFunction::js_return_value_from_native_call(GIFunctionInfo *function_info,
+Local<Value> GIRFunction::js_return_value_from_native_call(CallPlan &plan,
                                                            Args &args,
                                                            GIArgument &native_call_result) {
-    // load the function's return type info
-    GITypeInfo return_type_info;
-    g_callable_info_load_return_type(function_info, &return_type_info);
-
     // if the function's metadata says to skip the return value (meaning the
     // return value is only useful in C) or the return value is void, then we can
     // skip the return value when determining what should be returned from native
-    // to JS.
-    bool skip_return_value = g_callable_info_skip_return(function_info) ||
-                             g_type_info_get_tag(&return_type_info) == GI_TYPE_TAG_VOID;
-    int number_of_return_values = skip_return_value ? args.out.size() : args.out.size() + 1;
+    // to JS. The call plan has already worked this out for us.
+    bool skip_return_value = plan.skip_return;
+    int number_of_return_values = skip_return_value ? plan.n_js_out_args : plan.n_js_out_args + 1;
 
     Local<Array> js_result_array = Nan::New<Array>(number_of_return_values);
 
     // if we should NOT skip the native return value, then we should convert it to
-    // JS and set it in position 0 of the returned value array
+    // JS and set it in position 0 of the returned value array. If it's an array
+    // then it's length may be in one of the arguments.
     if (!skip_return_value) {
-        Local<Value> js_return_value = Args::from_g_type(&native_call_result, &return_type_info, 0);
+        Local<Value> js_return_value = Args::from_g_type(&native_call_result,
+                                                         &plan.return_type_info,
+                                                         args.array_length(plan.return_array_length_index),
+                                                         plan.return_transfer);
         js_result_array->Set(0, js_return_value);
     }
 
-    // We need to handle OUT arguments from the native call.
-    // If we had some out args then
-    // foreach native argument, if it's an our arg, grab the next out arg from
-    // args and add it to the next position in the js_result_array. The code here
-    // is a bit confusing because `g_callable_info_load_arg(info, index)` requires
-    // the argument index where the index is relative to ALL arguments where as
-    // args.out.data() is an array of just the OUT args (doesn't include IN args)
-    // so we can't just loop over args.out :(
+    // We need to handle OUT (and INOUT) arguments from the native call.
+    // foreach native argument, if it's an out arg, grab the value the native
+    // function wrote and add it to the next position in the js_result_array.
+    // Array lengths are hidden, they're only used to convert their array.
     int js_results_array_pos = skip_return_value ? 0 : 1; // if there is a return_value then we need to
                                                           // offset the out args by 1 i.e.
                                                           // [return_value, out-arg-1, out-arg-2, ...]
-    int next_out_arg_pos = 0;
-    if (args.out.size() > 0) {
-        for (int i = 0; i < g_callable_info_get_n_args(function_info); i++) {
-            GIArgInfo argument_info;
-            g_callable_info_load_arg(function_info, i, &argument_info);
-            GIDirection argument_direction = g_arg_info_get_direction(&argument_info);
-            if (argument_direction == GI_DIRECTION_OUT) {
-                GITypeInfo out_arg_type_info;
-                g_arg_info_load_type(&argument_info, &out_arg_type_info);
-                js_result_array->Set(js_results_array_pos,
-                                     Args::from_g_type(&args.out[next_out_arg_pos], &out_arg_type_info, 0));
-                next_out_arg_pos += 1;
-                js_results_array_pos += 1;
-            }
+    for (ArgPlan &argument : plan.args) {
+        if (argument.out_index < 0 || argument.is_array_length) {
+            continue;
         }
+        js_result_array->Set(js_results_array_pos,
+                             Args::from_g_type(args.out_value(argument),
+                                               &argument.type_info,
+                                               args.array_length(argument.array_length_index),
+                                               argument.transfer));
+        js_results_array_pos += 1;
     }
 
     // based on the number of return values from the native function call we'll
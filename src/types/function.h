@@ -6,6 +6,7 @@
 #include <v8.h>
 #include <map>
 #include "arguments.h"
+#include "call_plan.h"
 
 namespace gir {
 
@@ -20,16 +21,13 @@ public:
 public:
     // call_native and call should be private
     // we are just waiting for GIRStruct to be rewritten
-    static GIArgument call_native(GIFunctionInfo *function_info, Args &function_arguments);
-    static v8::Local<v8::Value> call(GObject *obj,
-                                     GIFunctionInfo *function_info,
-                                     const Nan::FunctionCallbackInfo<v8::Value> &args);
+    static GIArgument call_native(CallPlan &plan, Args &function_arguments);
+    static v8::Local<v8::Value> call(GObject *obj, CallPlan &plan, const Nan::FunctionCallbackInfo<v8::Value> &args);
 
 private:
     GIRFunction() = default;
-    static Local<Value> js_return_value_from_native_call(GIFunctionInfo *function_info,
-                                                         Args &args,
-                                                         GIArgument &native_call_result);
+    static void invoke(CallPlan &plan, Args &args, GIArgument *return_value, GError **error);
+    static Local<Value> js_return_value_from_native_call(CallPlan &plan, Args &args, GIArgument &native_call_result);
     static NAN_METHOD(InvokeFunction);
     static NAN_METHOD(InvokeMethod);
 };
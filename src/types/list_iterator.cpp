@@ -0,0 +1,97 @@
+#include "list_iterator.h"
+#include "arguments.h"
+#include "exceptions.h"
+
+namespace gir {
+
+Local<Object> GIRListIterator::create(gpointer list,
+                                      bool is_slist,
+                                      GITypeInfo *element_type_info,
+                                      GITransfer transfer) {
+    // take ownership of whatever we weren't given so the list can't change
+    // (or be freed) underneath the iterator.
+    if (transfer == GI_TRANSFER_NOTHING) {
+        list = Args::copy_list(list, is_slist);
+    }
+    if (transfer != GI_TRANSFER_EVERYTHING) {
+        for (gpointer node = list; node != nullptr; node = Args::list_next(node, is_slist)) {
+            gpointer &element = Args::list_data(node, is_slist);
+            element = Args::copy_element(element, element_type_info);
+        }
+    }
+
+    Local<Object> instance = Nan::NewInstance(GIRListIterator::get_constructor()).ToLocalChecked();
+    GIRListIterator *iterator = new GIRListIterator();
+    iterator->list = list;
+    iterator->current = list;
+    iterator->is_slist = is_slist;
+    iterator->element_type_info = GIRInfoUniquePtr(g_base_info_ref(element_type_info));
+    iterator->Wrap(instance);
+    return instance;
+}
+
+GIRListIterator::~GIRListIterator() {
+    // elements before current have already been released by next()
+    for (gpointer node = this->current; node != nullptr; node = Args::list_next(node, this->is_slist)) {
+        Args::free_element(Args::list_data(node, this->is_slist), this->element_type_info.get());
+    }
+    Args::free_list(this->list, this->is_slist);
+}
+
+Local<Function> GIRListIterator::get_constructor() {
+    static Nan::Persistent<FunctionTemplate> persistent_template;
+    if (persistent_template.IsEmpty()) {
+        Local<FunctionTemplate> object_template = Nan::New<FunctionTemplate>();
+        object_template->SetClassName(Nan::New("ListIterator").ToLocalChecked());
+        object_template->InstanceTemplate()->SetInternalFieldCount(1);
+        Nan::SetPrototypeMethod(object_template, "next", GIRListIterator::next);
+        object_template->PrototypeTemplate()->Set(Symbol::GetIterator(Isolate::GetCurrent()),
+                                                  Nan::New<FunctionTemplate>(GIRListIterator::iterator));
+        persistent_template.Reset(object_template);
+    }
+    return Nan::GetFunction(Nan::New(persistent_template)).ToLocalChecked();
+}
+
+/**
+ * Implements the iterator protocol, returning { value, done }
+ */
+NAN_METHOD(GIRListIterator::next) {
+    GIRListIterator *that = Nan::ObjectWrap::Unwrap<GIRListIterator>(info.This());
+    Local<Object> result = Nan::New<Object>();
+
+    if (that->current == nullptr) {
+        Nan::Set(result, Nan::New("value").ToLocalChecked(), Nan::Undefined());
+        Nan::Set(result, Nan::New("done").ToLocalChecked(), Nan::True());
+        info.GetReturnValue().Set(result);
+        return;
+    }
+
+    gpointer &element = Args::list_data(that->current, that->is_slist);
+    Local<Value> js_element;
+    try {
+        GIArgument element_argument = Args::pointer_to_g_argument(element, that->element_type_info.get());
+        js_element = Args::from_g_type(&element_argument, that->element_type_info.get(), -1);
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
+        return;
+    }
+
+    // the JS value has it's own copy (or reference) now
+    Args::free_element(element, that->element_type_info.get());
+    element = nullptr;
+    that->current = Args::list_next(that->current, that->is_slist);
+
+    Nan::Set(result, Nan::New("value").ToLocalChecked(), js_element);
+    Nan::Set(result, Nan::New("done").ToLocalChecked(), Nan::False());
+    info.GetReturnValue().Set(result);
+}
+
+/**
+ * iterator[Symbol.iterator]() returns the iterator itself so it can be used
+ * with for...of and spread syntax.
+ */
+NAN_METHOD(GIRListIterator::iterator) {
+    info.GetReturnValue().Set(info.This());
+}
+
+} // namespace gir
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <girepository.h>
+#include <glib.h>
+#include <nan.h>
+#include <v8.h>
+#include "util.h"
+
+namespace gir {
+
+using namespace v8;
+
+/**
+ * A JS iterator over a native GList or GSList. Elements are only converted to
+ * JS when next() reaches them, so large lists don't have to be converted (or
+ * held in a JS array) all at once. These are returned instead of arrays when
+ * the lazyLists option is set (see configure()).
+ *
+ * The iterator always owns the list and it's elements, which it releases
+ * as it goes and when it's garbage collected.
+ */
+class GIRListIterator : public Nan::ObjectWrap {
+public:
+    static Local<Object> create(gpointer list, bool is_slist, GITypeInfo *element_type_info, GITransfer transfer);
+
+    ~GIRListIterator();
+
+private:
+    gpointer list = nullptr;
+    gpointer current = nullptr;
+    bool is_slist = false;
+    GIRInfoUniquePtr element_type_info;
+
+    static Local<Function> get_constructor();
+
+    static NAN_METHOD(next);
+    static NAN_METHOD(iterator);
+};
+
+} // namespace gir
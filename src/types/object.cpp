@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "closure.h"
+#include "exceptions.h"
+#include "int64.h"
 #include "namespace_loader.h"
 #include "object.h"
 #include "types/function.h"
@@ -16,10 +20,6 @@ using namespace std;
 
 namespace gir {
 
-// initialize static properties
-std::vector<ObjectFunctionTemplate *> GIRObject::templates;
-std::set<GIRObject *> GIRObject::instances;
-
 GIRObject::GIRObject(GIObjectInfo *object_info, map<string, GValue> &properties) {
     this->info = object_info;
 
@@ -48,6 +48,49 @@ GIRObject::GIRObject(GIObjectInfo *object_info, map<string, GValue> &properties)
         }
         this->obj = G_OBJECT(g_object_newv(object_type, parameters.size(), parameters.data()));
 #endif
+        // we own the reference g_object_new() gave us, but if the object is floating
+        // (e.g. a GtkWidget) then we need to sink it to actually own it.
+        if (g_object_is_floating(this->obj)) {
+            g_object_ref_sink(this->obj);
+        }
+        g_object_set_qdata(this->obj, GIRObject::wrapper_quark(), this);
+    }
+}
+
+GIRObject::~GIRObject() {
+    if (this->obj != nullptr) {
+        // only forget the GObject's wrapper if it's still us, a newer wrapper
+        // may have been created after our JS object was collected.
+        if (g_object_get_qdata(this->obj, GIRObject::wrapper_quark()) == this) {
+            g_object_set_qdata(this->obj, GIRObject::wrapper_quark(), nullptr);
+        }
+        g_object_remove_toggle_ref(this->obj, GIRObject::toggle_notify, this);
+    }
+}
+
+/**
+ * Replaces the (normal) reference the wrapper holds on it's GObject with a
+ * toggle reference. While anything else holds a reference to the GObject the
+ * JS wrapper is kept alive (strong) and once the wrapper's reference is the
+ * only one left the wrapper becomes weak, so it can be garbage collected and
+ * release the GObject. This means that JS callbacks (e.g. signal handlers)
+ * that capture their own wrapper don't keep the GObject alive forever.
+ * The wrapper's JS object must already be wrapped (see Nan::ObjectWrap::Wrap).
+ */
+void GIRObject::take_toggle_ref() {
+    // start strong, toggle_notify makes us weak if the toggle reference
+    // turns out to be the only one once our normal reference is dropped.
+    this->Ref();
+    g_object_add_toggle_ref(this->obj, GIRObject::toggle_notify, this);
+    g_object_unref(this->obj);
+}
+
+void GIRObject::toggle_notify(gpointer data, GObject *obj, gboolean is_last_ref) {
+    GIRObject *that = static_cast<GIRObject *>(data);
+    if (is_last_ref) {
+        that->Unref(); // the wrapper can be collected
+    } else {
+        that->Ref(); // native code is using the object again
     }
 }
 
@@ -55,7 +98,13 @@ GObject *GIRObject::get_gobject() {
     return this->obj;
 }
 
-Local<Value> GIRObject::from_existing(GObject *existing_gobject, GIObjectInfo *object_info) {
+/**
+ * returns the JS wrapper for a GObject that came from native code, creating
+ * one if it doesn't have one. transfer says whether we were given a reference
+ * to the object (GI_TRANSFER_EVERYTHING), which the wrapper adopts (or drops
+ * if there's already a wrapper holding it's own).
+ */
+Local<Value> GIRObject::from_existing(GObject *existing_gobject, GIObjectInfo *object_info, GITransfer transfer) {
     // sanity check our parameters
     if (existing_gobject == nullptr || !G_IS_OBJECT(existing_gobject)) {
         return Nan::Undefined(); // FIXME: perhaps throw an error?
@@ -64,16 +113,21 @@ Local<Value> GIRObject::from_existing(GObject *existing_gobject, GIObjectInfo *o
     // if there's already an existing Wrapper (instance) then return that
     MaybeLocal<Value> existing_gir_object = GIRObject::get_instance(existing_gobject);
     if (!existing_gir_object.IsEmpty()) {
+        if (transfer == GI_TRANSFER_EVERYTHING) {
+            g_object_unref(existing_gobject);
+        }
         return existing_gir_object.ToLocalChecked();
     }
 
-    // find/create an object template, then initialize it with the existing GObject
+    // find/create an object template, then initialize it with the existing GObject.
+    // the External tells the constructor not to create a GObject of it's own.
     ObjectFunctionTemplate *oft = GIRObject::find_or_create_template_from_object_info(object_info);
     Local<Function> instance_constructor = Nan::GetFunction(Nan::New(oft->object_template)).ToLocalChecked();
-    Local<Object> instance = Nan::NewInstance(instance_constructor).ToLocalChecked();
+    Local<Value> constructor_args[] = {Nan::New<External>((void *)existing_gobject)};
+    Local<Object> instance = Nan::NewInstance(instance_constructor, 1, constructor_args).ToLocalChecked();
     GIRObject *gir_wrapper = ObjectWrap::Unwrap<GIRObject>(instance);
     gir_wrapper->info = oft->info;
-    gir_wrapper->obj = existing_gobject; // TODO: should we g_object_ref()?
+    gir_wrapper->set_instance(existing_gobject, transfer);
     return instance;
 }
 
@@ -93,14 +147,13 @@ map<string, GValue> GIRObject::parse_constructor_argument(Local<Object> properti
 }
 
 GType GIRObject::get_object_property_type(GIObjectInfo *object_info, const char *property_name) {
-    void *klass = g_type_class_ref(g_registered_type_info_get_g_type(object_info));
-    GParamSpec *param_spec = g_object_class_find_property(G_OBJECT_CLASS(klass), property_name);
-    g_type_class_unref(klass);
-    if (param_spec == nullptr) {
+    ObjectPropertyTable *properties = GIRObject::get_property_table(g_registered_type_info_get_g_type(object_info));
+    ObjectProperty *property = properties->find(property_name);
+    if (property == nullptr) {
         return G_TYPE_INVALID; // signal that the type doesn't exist or is invalid
                                // because we can't find it!
     }
-    return G_PARAM_SPEC_VALUE_TYPE(param_spec);
+    return G_PARAM_SPEC_VALUE_TYPE(property->param_spec);
 }
 
 ObjectFunctionTemplate *GIRObject::create_object_template(GIObjectInfo *object_info) {
@@ -118,7 +171,7 @@ ObjectFunctionTemplate *GIRObject::create_object_template(GIObjectInfo *object_i
     oft->type = g_registered_type_info_get_g_type(object_info);
     oft->type_name = (char *)g_base_info_get_name(object_info);
     oft->namespace_ = (char *)g_base_info_get_namespace(object_info);
-    GIRObject::templates.push_back(oft);
+    TemplateRegistry::insert(oft);
 
     // set the class name
     object_template->SetClassName(Nan::New(oft->type_name).ToLocalChecked());
@@ -126,16 +179,6 @@ ObjectFunctionTemplate *GIRObject::create_object_template(GIObjectInfo *object_i
     // Create instance template
     v8::Local<v8::ObjectTemplate> object_instance_template = object_template->InstanceTemplate();
     object_instance_template->SetInternalFieldCount(1);
-    // Create external to hold GIBaseInfo and set it
-    v8::Handle<v8::External> info_handle = Nan::New<v8::External>((void *)g_base_info_ref(oft->info));
-    // Set properties handlers
-    SetNamedPropertyHandler(object_instance_template,
-                            GIRObject::property_get_handler,
-                            GIRObject::property_set_handler,
-                            GIRObject::property_query_handler,
-                            nullptr,
-                            nullptr,
-                            info_handle);
 
     int number_of_constants = g_object_info_get_n_constants(oft->info);
     for (int i = 0; i < number_of_constants; i++) {
@@ -150,6 +193,8 @@ ObjectFunctionTemplate *GIRObject::create_object_template(GIObjectInfo *object_i
     }
 
     GIRObject::register_methods(oft->info, oft->namespace_, object_template);
+    // properties are defined after methods so a property wins if their names clash
+    GIRObject::register_properties(oft->info, object_template);
     GIRObject::set_custom_prototype_methods(object_template);
     GIRObject::extend_parent(object_template, oft->info);
 
@@ -183,17 +228,8 @@ void GIRObject::extend_parent(Local<FunctionTemplate> &object_template, GIObject
     g_base_info_unref(parent_object_info);
 }
 
-ObjectFunctionTemplate *GIRObject::find_template_from_object_info(GIObjectInfo *object_info) {
-    for (auto oft : GIRObject::templates) {
-        if (g_base_info_equal(object_info, oft->info)) {
-            return oft;
-        }
-    }
-    return nullptr;
-}
-
 ObjectFunctionTemplate *GIRObject::find_or_create_template_from_object_info(GIObjectInfo *object_info) {
-    ObjectFunctionTemplate *oft = GIRObject::find_template_from_object_info(object_info);
+    ObjectFunctionTemplate *oft = TemplateRegistry::find(object_info);
     if (oft == nullptr) {
         return GIRObject::create_object_template(object_info);
     }
@@ -205,32 +241,185 @@ void GIRObject::set_custom_prototype_methods(Local<FunctionTemplate> &object_tem
     // This method is used to connect signals to the underlying gobject.
     Nan::SetPrototypeMethod(object_template, "connect", GIRObject::connect);
 
+    // 'connectAfter' runs the callback after the signal's default handler and
+    // 'connectOnce' disconnects the callback the first time it's called.
+    Nan::SetPrototypeMethod(object_template, "connectAfter", GIRObject::connect_after);
+    Nan::SetPrototypeMethod(object_template, "connectOnce", GIRObject::connect_once);
+
     // Add the 'disconnect' method to the target.
     // This method is used to disconnect signals connected using 'connect()'
     Nan::SetPrototypeMethod(object_template, "disconnect", GIRObject::disconnect);
+
+    // 'disconnectAll' disconnects every handler JS has connected to the object,
+    // or just those connected with the given group, in a single call.
+    Nan::SetPrototypeMethod(object_template, "disconnectAll", GIRObject::disconnect_all);
+
+    // Add the 'getProperties' and 'setProperties' methods to the target.
+    // These get or set many properties of the underlying gobject at once.
+    Nan::SetPrototypeMethod(object_template, "getProperties", GIRObject::get_properties);
+    Nan::SetPrototypeMethod(object_template, "setProperties", GIRObject::set_properties);
+}
+
+GQuark GIRObject::wrapper_quark() {
+    static GQuark quark = g_quark_from_static_string("node-gir-wrapper");
+    return quark;
+}
+
+GQuark GIRObject::signal_handlers_quark() {
+    static GQuark quark = g_quark_from_static_string("node-gir-signal-handlers");
+    return quark;
+}
+
+/**
+ * Returns the table of handlers JS has connected to obj. If there isn't one
+ * yet it's created when create is true, otherwise nullptr is returned.
+ * The table is freed with the GObject.
+ */
+SignalHandlerTable *GIRObject::get_signal_handler_table(GObject *obj, bool create) {
+    auto table = (SignalHandlerTable *)g_object_get_qdata(obj, GIRObject::signal_handlers_quark());
+    if (table == nullptr && create) {
+        table = new SignalHandlerTable();
+        g_object_set_qdata_full(obj, GIRObject::signal_handlers_quark(), table, [](gpointer data) {
+            delete (SignalHandlerTable *)data;
+        });
+    }
+    return table;
+}
+
+/**
+ * Removes a handler from obj's table once it's been disconnected.
+ */
+void GIRObject::forget_signal_handler(GObject *obj, gulong handler_id) {
+    SignalHandlerTable *table = GIRObject::get_signal_handler_table(obj, false);
+    if (table != nullptr) {
+        table->groups.erase(handler_id);
+    }
+
+    Nan::HandleScope scope;
+    MaybeLocal<Value> wrapper = GIRObject::get_instance(obj);
+    if (!wrapper.IsEmpty()) {
+        Local<Object> callbacks = GIRObject::get_signal_callbacks(wrapper.ToLocalChecked().As<Object>());
+        Nan::Delete(callbacks, (uint32_t)handler_id);
+    }
+}
+
+/**
+ * Returns the object (a private property of the wrapper) that holds the JS
+ * callbacks of the wrapper's signal handlers by handler id. The callbacks are
+ * only weakly held by their closures, so they live for as long as the wrapper
+ * does. The wrapper is kept alive while native code holds the GObject (see
+ * take_toggle_ref) so the callbacks are too.
+ */
+Local<Object> GIRObject::get_signal_callbacks(Local<Object> wrapper) {
+    Local<String> key = Nan::New("node-gir:signal-callbacks").ToLocalChecked();
+    Local<Value> callbacks = Nan::GetPrivate(wrapper, key).ToLocalChecked();
+    if (!callbacks->IsObject()) {
+        callbacks = Nan::New<Object>();
+        Nan::SetPrivate(wrapper, key, callbacks);
+    }
+    return callbacks.As<Object>();
 }
 
+/**
+ * Each GObject that has a JS wrapper stores a pointer to it's GIRObject as
+ * qdata, so finding the wrapper for a GObject doesn't depend on how many
+ * wrappers exist. The qdata is removed when the wrapper is garbage collected.
+ */
 MaybeLocal<Value> GIRObject::get_instance(GObject *obj) {
-    for (GIRObject *gir_object : GIRObject::instances) {
-        if (gir_object->obj == obj) {
-            return MaybeLocal<Value>(gir_object->handle());
-        }
+    GIRObject *gir_object = (GIRObject *)g_object_get_qdata(obj, GIRObject::wrapper_quark());
+    if (gir_object != nullptr) {
+        return MaybeLocal<Value>(gir_object->handle());
     }
     return MaybeLocal<Value>();
 }
 
-GIPropertyInfo *GIRObject::find_property(GIObjectInfo *object_info,
-                                         char *property_name) { // FIXME: use a unique_pointer with std::move to return
-                                                                // ownership
-    int num_properties = g_object_info_get_n_properties(object_info);
-    for (int i = 0; i < num_properties; i++) {
-        GIPropertyInfo *prop = g_object_info_get_property(object_info, i);
-        if (strcmp(g_base_info_get_name(prop), property_name) == 0) {
-            return prop;
+/**
+ * Makes this (empty) wrapper the JS wrapper for obj. The wrapper holds a
+ * toggle reference to obj (see take_toggle_ref) so that the pointer stored on
+ * the wrapper can't outlive the GObject.
+ */
+void GIRObject::set_instance(GObject *obj, GITransfer transfer) {
+    // a floating reference is always taken over by sinking it. Otherwise the
+    // wrapper adopts the reference it was given or adds one of it's own.
+    if (g_object_is_floating(obj)) {
+        g_object_ref_sink(obj);
+    } else if (transfer != GI_TRANSFER_EVERYTHING) {
+        g_object_ref(obj);
+    }
+    this->obj = obj;
+    g_object_set_qdata(obj, GIRObject::wrapper_quark(), this);
+    this->take_toggle_ref();
+}
+
+ObjectProperty *ObjectPropertyTable::find(const char *name) {
+    auto found = this->by_name.find(name);
+    return found == this->by_name.end() ? nullptr : found->second;
+}
+
+ObjectPropertyTable *GIRObject::get_property_table(GType type) {
+    static unordered_map<GType, ObjectPropertyTable *> property_tables; // lives as long as the classes do
+    auto found = property_tables.find(type);
+    if (found != property_tables.end()) {
+        return found->second;
+    }
+    ObjectPropertyTable *properties = GIRObject::build_property_table(type);
+    property_tables[type] = properties;
+    return properties;
+}
+
+ObjectPropertyTable *GIRObject::build_property_table(GType type) {
+    ObjectPropertyTable *table = new ObjectPropertyTable();
+
+    // we keep a reference on the class so the GParamSpecs we store stay valid
+    GObjectClass *klass = G_OBJECT_CLASS(g_type_class_ref(type));
+    guint n_param_specs = 0;
+    GParamSpec **param_specs = g_object_class_list_properties(klass, &n_param_specs);
+
+    vector<GType> owner_types;
+    for (guint i = 0; i < n_param_specs; i++) {
+        GParamSpec *param_spec = param_specs[i];
+        ObjectProperty *property = new ObjectProperty();
+        property->param_spec = param_spec;
+        property->fundamental_type = G_TYPE_FUNDAMENTAL(param_spec->value_type);
+        property->readable = (param_spec->flags & G_PARAM_READABLE) != 0;
+        property->writable = (param_spec->flags & G_PARAM_WRITABLE) != 0;
+        table->properties.push_back(unique_ptr<ObjectProperty>(property));
+
+        string name = string(param_spec->name);
+        table->by_name[name] = property;
+        std::replace(name.begin(), name.end(), '-', '_');
+        table->by_name[name] = property;
+
+        if (std::find(owner_types.begin(), owner_types.end(), param_spec->owner_type) == owner_types.end()) {
+            owner_types.push_back(param_spec->owner_type);
         }
-        g_base_info_unref(prop);
     }
-    return nullptr;
+    g_free(param_specs);
+
+    // properties are described by the typelib info of the type that declares
+    // them, so visit each declaring type once and match up it's properties
+    for (GType owner_type : owner_types) {
+        auto owner_info = GIRInfoUniquePtr(g_irepository_find_by_gtype(g_irepository_get_default(), owner_type));
+        if (owner_info == nullptr) {
+            continue;
+        }
+        bool is_object = GI_IS_OBJECT_INFO(owner_info.get());
+        if (!is_object && !GI_IS_INTERFACE_INFO(owner_info.get())) {
+            continue;
+        }
+        int n_properties = is_object ? g_object_info_get_n_properties(owner_info.get())
+                                     : g_interface_info_get_n_properties(owner_info.get());
+        for (int i = 0; i < n_properties; i++) {
+            auto property_info = GIRInfoUniquePtr(is_object ? g_object_info_get_property(owner_info.get(), i)
+                                                            : g_interface_info_get_property(owner_info.get(), i));
+            ObjectProperty *property = table->find(g_base_info_get_name(property_info.get()));
+            if (property != nullptr && property->param_spec->owner_type == owner_type) {
+                property->property_info = move(property_info);
+            }
+        }
+    }
+
+    return table;
 }
 
 void GIRObject::register_methods(GIObjectInfo *object_info,
@@ -243,6 +432,10 @@ void GIRObject::register_methods(GIObjectInfo *object_info,
         num_methods = g_interface_info_get_n_methods(object_info);
     }
 
+    // all of the class' lazy method stubs share the class' info (which lives
+    // for as long as the class' template does).
+    Local<External> object_info_extern = Nan::New<External>((void *)object_info);
+
     for (int i = 0; i < num_methods; i++) {
         GIFunctionInfo *function_info = nullptr; // FIXME: use GIRInfoUniquePtr
         if (GI_IS_OBJECT_INFO(object_info)) {
@@ -250,7 +443,9 @@ void GIRObject::register_methods(GIObjectInfo *object_info,
         } else {
             function_info = g_interface_info_get_method(object_info, i);
         }
-        GIRObject::set_method(object_template, function_info); // FIXME: if this throws then we leak function_info
+        GIRObject::set_method(object_template,
+                              function_info,
+                              object_info_extern); // FIXME: if this throws then we leak function_info
         g_base_info_unref(function_info);
     }
 }
@@ -260,15 +455,25 @@ void GIRObject::register_methods(GIObjectInfo *object_info,
  * to define either a static or prototype method on the target, depending on the
  * flags of the GIFunctionInfo.
  * It will also apply a snake_case to camelCase conversion to function name.
+ *
+ * Prototype methods are only stubs (see GIRObject::lazy_method_getter), the
+ * method itself isn't built until the first time it's accessed. Most classes
+ * have a lot of methods and only a few of them are ever used.
  */
-void GIRObject::set_method(Local<FunctionTemplate> &target, GIFunctionInfo *function_info) {
+void GIRObject::set_method(Local<FunctionTemplate> &target,
+                           GIFunctionInfo *function_info,
+                           Local<External> &object_info_extern) {
     const char *native_name = g_base_info_get_name(function_info);
     string js_name = Util::to_camel_case(std::string(native_name));
     Local<String> js_function_name = Nan::New(js_name.c_str()).ToLocalChecked();
     if (g_function_info_get_flags(function_info) & GI_FUNCTION_IS_METHOD) {
         // if the function is a method, then we want to set it on the prototype
         // of the target, as a GI_FUNCTION_IS_METHOD is an instance method.
-        target->PrototypeTemplate()->Set(js_function_name, GIRFunction::create_method(function_info));
+        Nan::SetAccessor(target->PrototypeTemplate(),
+                         js_function_name,
+                         GIRObject::lazy_method_getter,
+                         GIRObject::lazy_method_setter,
+                         object_info_extern);
     } else {
         // else if it's not a method, then we want to set it as a static function
         // on the target itgir_object (not the prototype)
@@ -276,6 +481,60 @@ void GIRObject::set_method(Local<FunctionTemplate> &target, GIFunctionInfo *func
     }
 }
 
+/**
+ * finds the method of an object or interface whose JS name is js_name.
+ * returns nullptr if there isn't one.
+ */
+GIRInfoUniquePtr GIRObject::find_method(GIBaseInfo *object_info, const char *js_name) {
+    bool is_object = GI_IS_OBJECT_INFO(object_info);
+
+    // most JS names map straight back to the native name
+    string native_name = Util::to_snake_case(string(js_name));
+    GIRInfoUniquePtr function_info = GIRInfoUniquePtr(
+            is_object ? g_object_info_find_method(object_info, native_name.c_str())
+                      : g_interface_info_find_method(object_info, native_name.c_str()));
+    if (function_info != nullptr) {
+        return function_info;
+    }
+
+    // but to_snake_case isn't an exact inverse of to_camel_case (e.g. for names
+    // with a digit after an underscore) so fallback to comparing every method
+    int num_methods = is_object ? g_object_info_get_n_methods(object_info)
+                                : g_interface_info_get_n_methods(object_info);
+    for (int i = 0; i < num_methods; i++) {
+        function_info = GIRInfoUniquePtr(is_object ? g_object_info_get_method(object_info, i)
+                                                   : g_interface_info_get_method(object_info, i));
+        if (Util::to_camel_case(string(g_base_info_get_name(function_info.get()))) == js_name) {
+            return function_info;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * builds a prototype method the first time it's accessed, then replaces
+ * it's stub on the prototype with the method so we never come through here
+ * for it again.
+ */
+NAN_GETTER(GIRObject::lazy_method_getter) {
+    GIBaseInfo *object_info = (GIBaseInfo *)Local<External>::Cast(info.Data())->Value();
+    Nan::Utf8String js_name(property);
+    GIRInfoUniquePtr function_info = GIRObject::find_method(object_info, *js_name);
+    if (function_info == nullptr) {
+        return;
+    }
+
+    Local<Function> method = Nan::GetFunction(GIRFunction::create_method(function_info.get())).ToLocalChecked();
+    Nan::DefineOwnProperty(info.Holder(), property, method);
+    info.GetReturnValue().Set(method);
+}
+
+NAN_SETTER(GIRObject::lazy_method_setter) {
+    // assigning to a method that hasn't been built yet only shadows the stub on
+    // the object it was assigned to, the prototype (info.Holder()) is shared.
+    Nan::DefineOwnProperty(info.This(), property, value);
+}
+
 NAN_METHOD(GIRObject::constructor) {
     if (!(info.Length() == 0 || info.Length() == 1)) {
         Nan::ThrowTypeError("constructors must take 0 or 1 argument");
@@ -286,6 +545,14 @@ NAN_METHOD(GIRObject::constructor) {
     Local<External> object_info_extern = Local<External>::Cast(info.Data());
     GIObjectInfo *object_info = (GIObjectInfo *)object_info_extern->Value();
 
+    // from_existing() creates an empty wrapper for a GObject that already exists
+    if (info.Length() == 1 && info[0]->IsExternal()) {
+        GIRObject *obj = new GIRObject();
+        obj->Wrap(info.This());
+        info.GetReturnValue().Set(info.This());
+        return;
+    }
+
     if (object_info == nullptr) {
         Nan::ThrowError("no type information available for object constructor! this is likely a "
                         "bug with node-gir!");
@@ -299,72 +566,260 @@ NAN_METHOD(GIRObject::constructor) {
 
     GIRObject *obj = new GIRObject(object_info, properties);
     obj->Wrap(info.This());
-    GIRObject::instances.insert(obj);
+    if (obj->obj != nullptr) {
+        obj->take_toggle_ref();
+    }
     info.GetReturnValue().Set(info.This());
 }
 
-NAN_PROPERTY_QUERY(GIRObject::property_query_handler) {
-    // FIXME: implement this
-    String::Utf8Value _name(property);
-    info.GetReturnValue().Set(Nan::New(0));
+/**
+ * defines an accessor on the class' prototype for each property the class
+ * declares (including properties of the interfaces it implements). Inherited
+ * properties are found through the parent class' prototype.
+ */
+void GIRObject::register_properties(GIObjectInfo *object_info, Local<FunctionTemplate> &object_template) {
+    Local<ObjectTemplate> prototype_template = object_template->PrototypeTemplate();
+
+    int n_properties = g_object_info_get_n_properties(object_info);
+    for (int i = 0; i < n_properties; i++) {
+        auto property_info = GIRInfoUniquePtr(g_object_info_get_property(object_info, i));
+        GIRObject::set_property_accessor(prototype_template, property_info.get());
+    }
+
+    int n_interfaces = g_object_info_get_n_interfaces(object_info);
+    for (int i = 0; i < n_interfaces; i++) {
+        auto interface_info = GIRInfoUniquePtr(g_object_info_get_interface(object_info, i));
+        int n_interface_properties = g_interface_info_get_n_properties(interface_info.get());
+        for (int j = 0; j < n_interface_properties; j++) {
+            auto property_info = GIRInfoUniquePtr(g_interface_info_get_property(interface_info.get(), j));
+            GIRObject::set_property_accessor(prototype_template, property_info.get());
+        }
+    }
 }
 
-NAN_PROPERTY_GETTER(GIRObject::property_get_handler) {
-    String::Utf8Value _name(property);
-    Handle<External> info_ptr = Handle<External>::Cast(info.Data());
-    GIBaseInfo *base_info = (GIBaseInfo *)info_ptr->Value();
-    if (base_info != nullptr) {
-        GIRObject *that = Nan::ObjectWrap::Unwrap<GIRObject>(info.This()->ToObject());
-        GParamSpec *pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(that->obj), *_name);
-        if (pspec) {
-            // Property is not readable
-            if (!(pspec->flags & G_PARAM_READABLE)) {
-                Nan::ThrowTypeError("property is not readable");
-            }
-            GIPropertyInfo *prop_info = GIRObject::find_property(base_info, *_name);
-            GType value_type = G_TYPE_FUNDAMENTAL(pspec->value_type);
-            GValue gvalue = {0, {{0}}};
-            g_value_init(&gvalue, pspec->value_type);
-            g_object_get_property(G_OBJECT(that->obj), *_name, &gvalue);
-            Local<Value> res = GIRValue::from_g_value(&gvalue, prop_info);
-            if (value_type != G_TYPE_OBJECT && value_type != G_TYPE_BOXED) {
-                g_value_unset(&gvalue);
-            }
-            if (prop_info) {
-                g_base_info_unref(prop_info);
-            }
-            info.GetReturnValue().Set(res);
+/**
+ * properties are accessible by their canonical name ("use-underline") and
+ * with underscores ("use_underline").
+ */
+void GIRObject::set_property_accessor(Local<ObjectTemplate> &prototype_template, GIPropertyInfo *property_info) {
+    // the accessor's data lives for as long as the class does
+    PropertyAccessor *accessor = new PropertyAccessor();
+    accessor->name = string(g_base_info_get_name(property_info));
+    Local<External> accessor_extern = Nan::New<External>((void *)accessor);
+
+    Nan::SetAccessor(prototype_template,
+                     Nan::New(accessor->name).ToLocalChecked(),
+                     GIRObject::property_getter,
+                     GIRObject::property_setter,
+                     accessor_extern);
+
+    string underscore_name = accessor->name;
+    std::replace(underscore_name.begin(), underscore_name.end(), '-', '_');
+    if (underscore_name != accessor->name) {
+        Nan::SetAccessor(prototype_template,
+                         Nan::New(underscore_name).ToLocalChecked(),
+                         GIRObject::property_getter,
+                         GIRObject::property_setter,
+                         accessor_extern);
+    }
+}
+
+/**
+ * finds the GIRObject and property that a property accessor was called for.
+ * returns false if the accessor wasn't called on a GIRObject (e.g. it was
+ * read from the prototype itself).
+ */
+bool GIRObject::unwrap_property_accessor(Local<Object> receiver,
+                                         Local<Value> data,
+                                         GIRObject **that,
+                                         ObjectProperty **object_property) {
+    if (receiver->InternalFieldCount() == 0) {
+        return false;
+    }
+    *that = Nan::ObjectWrap::Unwrap<GIRObject>(receiver);
+    if ((*that)->obj == nullptr) {
+        return false;
+    }
+
+    // the property is looked up the first time the accessor is used. A property
+    // has the same pspec name and value type in every class that has it so the
+    // result can be shared by all of them.
+    PropertyAccessor *accessor = (PropertyAccessor *)Local<External>::Cast(data)->Value();
+    if (accessor->property == nullptr) {
+        ObjectPropertyTable *properties = GIRObject::get_property_table(G_OBJECT_TYPE((*that)->obj));
+        accessor->property = properties->find(accessor->name.c_str());
+    }
+    *object_property = accessor->property;
+    return *object_property != nullptr;
+}
+
+NAN_GETTER(GIRObject::property_getter) {
+    GIRObject *that;
+    ObjectProperty *object_property;
+    if (!GIRObject::unwrap_property_accessor(info.This(), info.Data(), &that, &object_property)) {
+        return;
+    }
+
+    // Property is not readable
+    if (!object_property->readable) {
+        Nan::ThrowTypeError("property is not readable");
+        return;
+    }
+    info.GetReturnValue().Set(GIRObject::get_property(that->obj, object_property));
+}
+
+NAN_SETTER(GIRObject::property_setter) {
+    GIRObject *that;
+    ObjectProperty *object_property;
+    if (!GIRObject::unwrap_property_accessor(info.This(), info.Data(), &that, &object_property)) {
+        return;
+    }
+
+    // Property is not writable
+    if (!object_property->writable) {
+        Nan::ThrowTypeError("property is not writable");
+        return;
+    }
+    GIRObject::set_property(that->obj, object_property, value);
+}
+
+Local<Value> GIRObject::get_property(GObject *obj, ObjectProperty *object_property) {
+    GParamSpec *pspec = object_property->param_spec;
+    GValue gvalue = {0, {{0}}};
+    g_value_init(&gvalue, pspec->value_type);
+    g_object_get_property(obj, pspec->name, &gvalue);
+    return GIRObject::property_value_to_js(&gvalue, object_property);
+}
+
+/**
+ * converts a property's value to JS and unsets the GValue (if that's safe).
+ */
+Local<Value> GIRObject::property_value_to_js(GValue *gvalue, ObjectProperty *object_property) {
+    Local<Value> res = GIRValue::from_g_value(gvalue, object_property->property_info.get());
+    if (object_property->fundamental_type != G_TYPE_OBJECT && object_property->fundamental_type != G_TYPE_BOXED) {
+        g_value_unset(gvalue);
+    }
+    return res;
+}
+
+/**
+ * finds a readable or writable property by name on the object, throwing a
+ * JS error and returning nullptr if there isn't one.
+ */
+ObjectProperty *GIRObject::find_property_or_throw(GIRObject *that, Local<Value> js_name, bool writable) {
+    Nan::Utf8String name(js_name);
+    ObjectProperty *object_property = GIRObject::get_property_table(G_OBJECT_TYPE(that->obj))->find(*name);
+    if (object_property == nullptr) {
+        Nan::ThrowError((string("unknown property '") + *name + "'").c_str());
+        return nullptr;
+    }
+    if (writable ? !object_property->writable : !object_property->readable) {
+        Nan::ThrowTypeError((string("property '") + *name + (writable ? "' is not writable" : "' is not readable"))
+                                    .c_str());
+        return nullptr;
+    }
+    return object_property;
+}
+
+/**
+ * obj.getProperties(['a', 'b', 'c']) returns { a, b, c }
+ * All of the properties are read from the native object in one call.
+ */
+NAN_METHOD(GIRObject::get_properties) {
+    if (info.Length() != 1 || !info[0]->IsArray()) {
+        Nan::ThrowTypeError("Invalid arguments: expected (Array)");
+        return;
+    }
+    GIRObject *that = Nan::ObjectWrap::Unwrap<GIRObject>(info.This());
+    Local<Array> js_names = Local<Array>::Cast(info[0]);
+    guint n_properties = js_names->Length();
+
+    vector<ObjectProperty *> properties(n_properties);
+    vector<const char *> names(n_properties);
+    for (guint i = 0; i < n_properties; i++) {
+        properties[i] = GIRObject::find_property_or_throw(that, js_names->Get(i), false);
+        if (properties[i] == nullptr) {
             return;
         }
+        names[i] = properties[i]->param_spec->name;
     }
 
-    // Fallback to defaults
-    info.GetReturnValue().Set(info.This()->GetPrototype()->ToObject()->Get(property));
+    // the GValues are zeroed here and initialized to each property's type by GObject
+    vector<GValue> values(n_properties);
+#if GLIB_CHECK_VERSION(2, 54, 0)
+    g_object_getv(that->obj, n_properties, names.data(), values.data());
+#else
+    for (guint i = 0; i < n_properties; i++) {
+        g_value_init(&values[i], properties[i]->param_spec->value_type);
+        g_object_get_property(that->obj, names[i], &values[i]);
+    }
+#endif
+
+    Local<Object> result = Nan::New<Object>();
+    for (guint i = 0; i < n_properties; i++) {
+        Nan::Set(result, js_names->Get(i), GIRObject::property_value_to_js(&values[i], properties[i]));
+    }
+    info.GetReturnValue().Set(result);
 }
 
-NAN_PROPERTY_SETTER(GIRObject::property_set_handler) {
-    String::Utf8Value property_name(property);
+/**
+ * obj.setProperties({ a, b, c })
+ * All of the properties are written to the native object in one call, with
+ * notify signals held back until every property has been set so that each
+ * changed property is only notified once.
+ */
+NAN_METHOD(GIRObject::set_properties) {
+    if (info.Length() != 1 || !info[0]->IsObject()) {
+        Nan::ThrowTypeError("Invalid arguments: expected (Object)");
+        return;
+    }
+    GIRObject *that = Nan::ObjectWrap::Unwrap<GIRObject>(info.This());
+    Local<Object> js_properties = info[0]->ToObject();
+    Local<Array> js_names = js_properties->GetOwnPropertyNames();
+    guint n_properties = js_names->Length();
 
-    v8::Handle<v8::External> info_ptr = v8::Handle<v8::External>::Cast(info.Data());
-    GIBaseInfo *base_info = (GIBaseInfo *)info_ptr->Value();
-    if (base_info != nullptr) {
-        GIRObject *that = Nan::ObjectWrap::Unwrap<GIRObject>(info.This()->ToObject());
-        GParamSpec *pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(that->obj), *property_name);
-        if (pspec) {
-            // Property is not readable
-            if (!(pspec->flags & G_PARAM_WRITABLE)) {
-                Nan::ThrowTypeError("property is not writable");
+    vector<const char *> names;
+    vector<GValue> values;
+    names.reserve(n_properties);
+    values.reserve(n_properties);
+    try {
+        for (guint i = 0; i < n_properties; i++) {
+            Local<Value> js_name = js_names->Get(i);
+            ObjectProperty *object_property = GIRObject::find_property_or_throw(that, js_name, true);
+            if (object_property == nullptr) {
+                break;
             }
+            GParamSpec *pspec = object_property->param_spec;
+            values.push_back(GIRValue::to_g_value(js_properties->Get(js_name), pspec->value_type));
+            names.push_back(pspec->name);
+        }
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
+    }
 
-            GValue g_value = GIRValue::to_g_value(value, pspec->value_type);
-            g_object_set_property(that->obj, *property_name, &g_value);
-            g_value_unset(&g_value);
-            return;
+    // only set the properties if they all converted successfully
+    if (names.size() == n_properties) {
+        g_object_freeze_notify(that->obj);
+#if GLIB_CHECK_VERSION(2, 54, 0)
+        g_object_setv(that->obj, n_properties, names.data(), values.data());
+#else
+        for (guint i = 0; i < n_properties; i++) {
+            g_object_set_property(that->obj, names[i], &values[i]);
         }
+#endif
+        g_object_thaw_notify(that->obj);
     }
 
-    // Fallback to defaults
-    info.This()->GetPrototype()->ToObject()->Set(property, value);
+    for (GValue &value : values) {
+        g_value_unset(&value);
+    }
+}
+
+void GIRObject::set_property(GObject *obj, ObjectProperty *object_property, Local<Value> value) {
+    GParamSpec *pspec = object_property->param_spec;
+    GValue g_value = GIRValue::to_g_value(value, pspec->value_type);
+    g_object_set_property(obj, pspec->name, &g_value);
+    g_value_unset(&g_value);
 }
 
 /**
@@ -372,9 +827,32 @@ NAN_PROPERTY_SETTER(GIRObject::property_set_handler) {
  * using a GIRClosure (a custom GClosure we've written to support
  * JS callback's)
  */
+/**
+ * connect(signal_name, callback, [options])
+ * options can contain:
+ * - coalesce: 'frame' or a number of milliseconds. Only the latest emission is
+ *   delivered to the callback, once per main loop iteration or interval.
+ * - filter: { detail, params } only emissions that match are delivered to the
+ *   callback. detail is a detail (such as a property name for 'notify') or a list
+ *   of them. params maps a param's position (as passed to the callback, so the
+ *   instance is 0) to the value, or list of values, it must have. Only integer,
+ *   enum, flags and boolean params can be filtered.
+ */
 NAN_METHOD(GIRObject::connect) {
-    if (info.Length() != 2 || !info[0]->IsString() || !info[1]->IsFunction()) {
-        Nan::ThrowError("Invalid arguments: expected (string, Function)");
+    GIRObject::connect_signal(info, false, false);
+}
+
+NAN_METHOD(GIRObject::connect_after) {
+    GIRObject::connect_signal(info, true, false);
+}
+
+NAN_METHOD(GIRObject::connect_once) {
+    GIRObject::connect_signal(info, false, true);
+}
+
+void GIRObject::connect_signal(const Nan::FunctionCallbackInfo<Value> &info, bool after, bool once) {
+    if (info.Length() < 2 || info.Length() > 3 || !info[0]->IsString() || !info[1]->IsFunction()) {
+        Nan::ThrowError("Invalid arguments: expected (string, Function, [options])");
         return;
     }
     GIRObject *gir_object = Nan::ObjectWrap::Unwrap<GIRObject>(info.This()->ToObject());
@@ -390,43 +868,151 @@ NAN_METHOD(GIRObject::connect) {
         return;
     }
 
-    // query for in-depth information about the target signal
-    // we can pass this to our closure constructor later so that it can
-    // find the GI type info for the signal.
-    GSignalQuery signal_query;
-    g_signal_query(signal_id, &signal_query);
-
-    auto target_info = GIRInfoUniquePtr(g_irepository_find_by_gtype(g_irepository_get_default(), signal_query.itype));
-    if (target_info == nullptr) {
-        Nan::ThrowError("unknown signal");
+    SignalOptions options;
+    try {
+        options = GIRObject::parse_signal_options(info[2], signal_id);
+        options.after = after;
+        options.once = once;
+        // a coalesced emission is delivered after the handler would have been
+        // disconnected (which drops the emission) so they can't be combined.
+        if (options.once && options.coalesce != SignalCoalesce::NONE) {
+            throw JSArgumentTypeError("connectOnce() handlers can't be coalesced");
+        }
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
         return;
     }
 
-    GIRInfoUniquePtr signal_info = nullptr;
-    if (GI_IS_OBJECT_INFO(target_info.get())) {
-        signal_info = GIRInfoUniquePtr(g_object_info_find_signal(target_info.get(), signal_name));
-    } else if (GI_IS_INTERFACE_INFO(target_info.get())) {
-        signal_info = GIRInfoUniquePtr(g_interface_info_find_signal(target_info.get(), signal_name));
-    }
-
-    // create a closure that will manage the signal callback to JS callback for us
-    GClosure *closure = GIRClosure::create(signal_info.get(), callback);
-    if (closure == nullptr) {
-        Nan::ThrowError("unknown signal");
-        return;
-    }
+    // create a closure that will manage the signal callback to JS callback for us.
+    // the closure converts the signal's values using a plan that's built from
+    // the signal's GSignalQuery (once per signal) so we don't need the typelib here.
+    GClosure *closure = GIRClosure::create_for_signal(signal_id, callback, options);
 
     // connect the closure to the signal using the signal_id and detail we've already found
     gulong handle_id = g_signal_connect_closure_by_id(gir_object->obj,
                                                       signal_id,
                                                       detail,
                                                       closure,
-                                                      FALSE); // TODO: support connecting with after=TRUE
+                                                      options.after ? TRUE : FALSE);
+    GIRClosure::set_handler_id(closure, handle_id);
+
+    // remember the handler so disconnectAll() can find it
+    GIRObject::get_signal_handler_table(gir_object->obj, true)->groups[handle_id] = options.group;
+
+    // the wrapper keeps the callback alive (see create_for_signal)
+    Nan::Set(GIRObject::get_signal_callbacks(info.This()), (uint32_t)handle_id, callback);
 
     // return the signal connection ID back to JS.
     info.GetReturnValue().Set(Nan::New((uint32_t)handle_id));
 }
 
+SignalOptions GIRObject::parse_signal_options(Local<Value> js_options, guint signal_id) {
+    SignalOptions options;
+    if (js_options.IsEmpty() || js_options->IsUndefined()) {
+        return options;
+    }
+    if (!js_options->IsObject()) {
+        throw JSArgumentTypeError("connect() options must be an object");
+    }
+
+    Local<Value> coalesce = Nan::Get(js_options.As<Object>(), Nan::New("coalesce").ToLocalChecked()).ToLocalChecked();
+    if (!coalesce->IsUndefined()) {
+        if (coalesce->IsString() && string(*Nan::Utf8String(coalesce)) == "frame") {
+            options.coalesce = SignalCoalesce::FRAME;
+        } else if (coalesce->IsNumber() && coalesce->NumberValue() > 0) {
+            options.coalesce = SignalCoalesce::INTERVAL;
+            options.coalesce_interval = coalesce->Uint32Value();
+        } else {
+            throw JSArgumentTypeError("coalesce must be 'frame' or a number of milliseconds");
+        }
+        // there's no return value to give GSignal when the emission is delivered later
+        if (SignalPlan::get(signal_id)->return_type != G_TYPE_NONE) {
+            throw JSArgumentTypeError("signals that return a value can't be coalesced");
+        }
+    }
+
+    Local<Value> filter = Nan::Get(js_options.As<Object>(), Nan::New("filter").ToLocalChecked()).ToLocalChecked();
+    if (!filter->IsUndefined()) {
+        options.filter = GIRObject::parse_signal_filter(filter, signal_id);
+    }
+
+    // any string (or number) can be used as a group token
+    Local<Value> group = Nan::Get(js_options.As<Object>(), Nan::New("group").ToLocalChecked()).ToLocalChecked();
+    if (!group->IsUndefined()) {
+        if (!group->IsString() && !group->IsNumber()) {
+            throw JSArgumentTypeError("group must be a string or a number");
+        }
+        options.group = *Nan::Utf8String(group);
+        if (options.group.empty()) {
+            throw JSArgumentTypeError("group can't be an empty string");
+        }
+    }
+    return options;
+}
+
+SignalFilter GIRObject::parse_signal_filter(Local<Value> js_filter, guint signal_id) {
+    SignalFilter filter;
+    if (!js_filter->IsObject()) {
+        throw JSArgumentTypeError("filter must be an object");
+    }
+    Local<Object> filter_object = js_filter.As<Object>();
+
+    Local<Value> detail = Nan::Get(filter_object, Nan::New("detail").ToLocalChecked()).ToLocalChecked();
+    if (!detail->IsUndefined()) {
+        Local<Array> details = GIRObject::to_array(detail);
+        for (guint32 i = 0; i < details->Length(); i++) {
+            Local<Value> name = details->Get(i);
+            if (!name->IsString()) {
+                throw JSArgumentTypeError("filter.detail must be a string or an array of strings");
+            }
+            // details such as property names are canonical (with dashes)
+            string detail_name = string(*Nan::Utf8String(name));
+            replace(detail_name.begin(), detail_name.end(), '_', '-');
+            filter.details.push_back(g_quark_from_string(detail_name.c_str()));
+        }
+    }
+
+    Local<Value> params = Nan::Get(filter_object, Nan::New("params").ToLocalChecked()).ToLocalChecked();
+    if (!params->IsUndefined()) {
+        if (!params->IsObject()) {
+            throw JSArgumentTypeError("filter.params must be an object");
+        }
+        SignalPlan *plan = SignalPlan::get(signal_id);
+        Local<Array> indexes = params.As<Object>()->GetOwnPropertyNames();
+        for (guint32 i = 0; i < indexes->Length(); i++) {
+            Local<Value> index = indexes->Get(i);
+            guint32 param_index = index->Uint32Value();
+            if (param_index >= plan->n_params || !SignalFilter::is_integer_type(plan->param_types[param_index])) {
+                stringstream message;
+                message << "can't filter on param " << *Nan::Utf8String(index)
+                        << ", only integer, enum, flags and boolean params can be filtered";
+                throw JSArgumentTypeError(message.str());
+            }
+
+            SignalParamFilter param_filter;
+            param_filter.index = param_index;
+            Local<Array> values = GIRObject::to_array(params.As<Object>()->Get(index));
+            for (guint32 j = 0; j < values->Length(); j++) {
+                param_filter.values.push_back(Int64::to_int64(values->Get(j)));
+            }
+            filter.params.push_back(param_filter);
+        }
+    }
+    return filter;
+}
+
+/**
+ * returns value if it's an array, otherwise an array containing just value
+ */
+Local<Array> GIRObject::to_array(Local<Value> value) {
+    if (value->IsArray()) {
+        return value.As<Array>();
+    }
+    Local<Array> array = Nan::New<Array>(1);
+    array->Set(0, value);
+    return array;
+}
+
 NAN_METHOD(GIRObject::disconnect) {
     if (info.Length() != 1 || !info[0]->IsNumber()) {
         Nan::ThrowTypeError("Invalid argument's, expected 1 number arg!");
@@ -435,7 +1021,46 @@ NAN_METHOD(GIRObject::disconnect) {
     gulong signal_handler_id = Nan::To<uint32_t>(info[0]).FromJust();
     GIRObject *that = Nan::ObjectWrap::Unwrap<GIRObject>(info.This());
     g_signal_handler_disconnect(that->obj, signal_handler_id);
+    GIRObject::forget_signal_handler(that->obj, signal_handler_id);
     info.GetReturnValue().Set(Nan::Undefined());
 }
 
+/**
+ * Disconnects every handler that JS connected to the object or, when a group
+ * is given, only the handlers connected with that group. Disconnecting a
+ * handler releases its closure (and the JS callback it holds).
+ * Returns the number of handlers that were disconnected.
+ */
+NAN_METHOD(GIRObject::disconnect_all) {
+    if (info.Length() > 1 || (info.Length() == 1 && !info[0]->IsString() && !info[0]->IsNumber())) {
+        Nan::ThrowTypeError("Invalid arguments: expected ([group])");
+        return;
+    }
+    GIRObject *that = Nan::ObjectWrap::Unwrap<GIRObject>(info.This());
+    bool all_groups = info.Length() == 0;
+    string group = all_groups ? string() : string(*Nan::Utf8String(info[0]));
+
+    SignalHandlerTable *table = GIRObject::get_signal_handler_table(that->obj, false);
+    uint32_t n_disconnected = 0;
+    if (table != nullptr) {
+        // collect the ids first, disconnecting a once-only handler's closure
+        // can't change the table but native code may have already disconnected
+        // some of the handlers so they're checked before being disconnected.
+        vector<gulong> handler_ids;
+        for (auto &entry : table->groups) {
+            if (all_groups || entry.second == group) {
+                handler_ids.push_back(entry.first);
+            }
+        }
+        for (gulong handler_id : handler_ids) {
+            if (g_signal_handler_is_connected(that->obj, handler_id)) {
+                g_signal_handler_disconnect(that->obj, handler_id);
+                n_disconnected++;
+            }
+            table->groups.erase(handler_id);
+        }
+    }
+    info.GetReturnValue().Set(Nan::New(n_disconnected));
+}
+
 } // namespace gir
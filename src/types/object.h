@@ -5,8 +5,11 @@
 #include <nan.h>
 #include <v8.h>
 #include <map>
-#include <set>
+#include <memory>
+#include <unordered_map>
 #include <vector>
+#include "internal/TemplateRegistry.h"
+#include "util.h"
 
 namespace gir {
 
@@ -14,36 +17,78 @@ using namespace v8;
 using namespace std;
 
 class GIRObject;
+struct SignalOptions;
+struct SignalFilter;
 
-using PersistentFunctionTemplate = Nan::Persistent<FunctionTemplate, CopyablePersistentTraits<FunctionTemplate>>;
+/**
+ * Everything we need to know to get or set a property on an object.
+ */
+struct ObjectProperty {
+    GParamSpec *param_spec;
+    GIRInfoUniquePtr property_info; // nullptr if the typelib doesn't describe the property
+    GType fundamental_type;
+    bool readable;
+    bool writable;
+};
+
+/**
+ * The properties of a class (including those it inherits) by name. Properties
+ * can be found by their canonical name ("use-underline") or with underscores
+ * ("use_underline"). A class' table is built once, the first time it's needed.
+ */
+struct ObjectPropertyTable {
+    vector<unique_ptr<ObjectProperty>> properties;
+    unordered_map<string, ObjectProperty *> by_name;
+
+    ObjectProperty *find(const char *name);
+};
+
+/**
+ * The data for a property accessor on a class' prototype. The property is
+ * resolved the first time the accessor is used.
+ */
+struct PropertyAccessor {
+    string name;
+    ObjectProperty *property = nullptr;
+};
 
-struct ObjectFunctionTemplate {
-    char *type_name;
-    GIObjectInfo *info; // FIXME: use GIRInfoUniquePtr
-    PersistentFunctionTemplate object_template;
-    GType type;
-    char *namespace_;
+/**
+ * The signal handlers that JS has connected to an object, by handler id, with
+ * the group each was connected in ("" if it wasn't given one). The table is
+ * kept as qdata on the GObject rather than on the wrapper, so handlers can
+ * still be found after the wrapper has been garbage collected.
+ */
+struct SignalHandlerTable {
+    unordered_map<gulong, string> groups;
 };
 
 class GIRObject : public Nan::ObjectWrap {
 private:
-    static std::set<GIRObject *> instances;                 // FIXME: use smart pointers
-    static std::vector<ObjectFunctionTemplate *> templates; // FIXME: use smart pointers
-    GObject *obj;
+    GObject *obj = nullptr;
     GIBaseInfo *info;
 
 public:
     static Local<Object> prepare(GIObjectInfo *object_info);
-    static Local<Value> from_existing(GObject *obj, GIObjectInfo *object_info);
+    static Local<Value> from_existing(GObject *obj,
+                                      GIObjectInfo *object_info,
+                                      GITransfer transfer = GI_TRANSFER_NOTHING);
     GObject *get_gobject();
+    static void forget_signal_handler(GObject *obj, gulong handler_id);
 
 private:
     GIRObject() = default;
     GIRObject(GIObjectInfo *info_, map<string, GValue> &properties);
+    ~GIRObject();
 
+    static GQuark wrapper_quark();
+    static GQuark signal_handlers_quark();
+    static SignalHandlerTable *get_signal_handler_table(GObject *obj, bool create);
+    static Local<Object> get_signal_callbacks(Local<Object> wrapper);
     static MaybeLocal<Value> get_instance(GObject *obj);
+    void set_instance(GObject *obj, GITransfer transfer);
+    void take_toggle_ref();
+    static void toggle_notify(gpointer data, GObject *obj, gboolean is_last_ref);
     static ObjectFunctionTemplate *create_object_template(GIObjectInfo *object_info);
-    static ObjectFunctionTemplate *find_template_from_object_info(GIObjectInfo *object_info);
     static ObjectFunctionTemplate *find_or_create_template_from_object_info(GIObjectInfo *object_info);
 
     static map<string, GValue> parse_constructor_argument(Local<Object> properties_object, GIObjectInfo *object_info);
@@ -52,18 +97,42 @@ private:
     static void register_methods(GIObjectInfo *object_info,
                                  const char *namespace_,
                                  Local<FunctionTemplate> &object_template);
-    static void set_method(Local<FunctionTemplate> &target, GIFunctionInfo *function_info);
+    static void set_method(Local<FunctionTemplate> &target,
+                           GIFunctionInfo *function_info,
+                           Local<External> &object_info_extern);
+    static GIRInfoUniquePtr find_method(GIBaseInfo *object_info, const char *js_name);
     static void set_custom_fields(Local<FunctionTemplate> &object_template, GIObjectInfo *object_info);
     static void set_custom_prototype_methods(Local<FunctionTemplate> &object_template);
     static void extend_parent(Local<FunctionTemplate> &object_template, GIObjectInfo *object_info);
-    static GIFunctionInfo *find_property(GIObjectInfo *inf, char *name);
+    static void register_properties(GIObjectInfo *object_info, Local<FunctionTemplate> &object_template);
+    static void set_property_accessor(Local<ObjectTemplate> &prototype_template, GIPropertyInfo *property_info);
+    static bool unwrap_property_accessor(Local<Object> receiver,
+                                         Local<Value> data,
+                                         GIRObject **that,
+                                         ObjectProperty **object_property);
+    static Local<Value> get_property(GObject *obj, ObjectProperty *object_property);
+    static void set_property(GObject *obj, ObjectProperty *object_property, Local<Value> value);
+    static Local<Value> property_value_to_js(GValue *gvalue, ObjectProperty *object_property);
+    static ObjectProperty *find_property_or_throw(GIRObject *that, Local<Value> js_name, bool writable);
+    static ObjectPropertyTable *get_property_table(GType type);
+    static ObjectPropertyTable *build_property_table(GType type);
+    static SignalOptions parse_signal_options(Local<Value> js_options, guint signal_id);
+    static SignalFilter parse_signal_filter(Local<Value> js_filter, guint signal_id);
+    static Local<Array> to_array(Local<Value> value);
 
+    static NAN_GETTER(lazy_method_getter);
+    static NAN_SETTER(lazy_method_setter);
     static NAN_METHOD(constructor);
+    static void connect_signal(const Nan::FunctionCallbackInfo<Value> &info, bool after, bool once);
     static NAN_METHOD(connect);
+    static NAN_METHOD(connect_after);
+    static NAN_METHOD(connect_once);
     static NAN_METHOD(disconnect);
-    static NAN_PROPERTY_GETTER(property_get_handler);
-    static NAN_PROPERTY_SETTER(property_set_handler);
-    static NAN_PROPERTY_QUERY(property_query_handler);
+    static NAN_METHOD(disconnect_all);
+    static NAN_METHOD(get_properties);
+    static NAN_METHOD(set_properties);
+    static NAN_GETTER(property_getter);
+    static NAN_SETTER(property_setter);
 };
 
 } // namespace gir
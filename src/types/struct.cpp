@@ -4,6 +4,7 @@
 
 #include "arguments.h"
 #include "function.h"
+#include "int64.h"
 #include "struct.h"
 #include "util.h"
 #include "values.h"
@@ -16,8 +17,6 @@ namespace gir {
 using namespace v8;
 using namespace std;
 
-PersistentObjectStore<GType, PersistentFunctionTemplate> GIRStruct::prepared_js_classes;
-
 gpointer GIRStruct::get_native_ptr() {
     return this->boxed_c_structure;
 }
@@ -25,10 +24,9 @@ gpointer GIRStruct::get_native_ptr() {
 Local<Value> GIRStruct::from_existing(gpointer c_structure, GIStructInfo *info) {
     GType gtype = g_registered_type_info_get_g_type(info);
     Local<Function> klass;
-    if (GIRStruct::prepared_js_classes.exists(gtype)) {
-        PersistentFunctionTemplate cached_js_class = GIRStruct::prepared_js_classes.at(gtype);
-        auto function_template = Nan::New(cached_js_class);
-        klass = function_template->GetFunction();
+    ObjectFunctionTemplate *oft = TemplateRegistry::find(info);
+    if (oft != nullptr) {
+        klass = Nan::New(oft->object_template)->GetFunction();
     } else {
         klass = GIRStruct::prepare(info);
     }
@@ -59,6 +57,11 @@ GIRStruct::~GIRStruct() {
 }
 
 Local<Function> GIRStruct::prepare(GIStructInfo *info) {
+    ObjectFunctionTemplate *existing_oft = TemplateRegistry::find(info);
+    if (existing_oft != nullptr) {
+        return Nan::New(existing_oft->object_template)->GetFunction();
+    }
+
     char *name = (char *)g_base_info_get_name(info);
     const char *namespace_ = g_base_info_get_namespace(info);
     g_base_info_ref(info);
@@ -67,11 +70,25 @@ Local<Function> GIRStruct::prepare(GIStructInfo *info) {
     Local<External> struct_info_extern = Nan::New<External>((void *)g_base_info_ref(info));
 
     // create the struct's constructor
-    // GIRStruct::constructor is expecting the GIStructInfo to be attached
-    // to the JS function (constructor)
-    Local<FunctionTemplate> object_template = Nan::New<FunctionTemplate>(GIRStruct::constructor, struct_info_extern);
-    GIRStruct::prepared_js_classes.insert(
-            make_pair(g_registered_type_info_get_g_type(info), PersistentFunctionTemplate(object_template)));
+    // GIRStruct::constructor is expecting the GIStructInfo (and the plan for
+    // it's native constructor) to be attached to the JS function (constructor)
+    StructConstructorData *constructor_data = new StructConstructorData();
+    constructor_data->struct_info = g_base_info_ref(info);
+    constructor_data->plan = nullptr;
+    GIRInfoUniquePtr native_constructor = GIRStruct::find_native_constructor(info);
+    if (native_constructor != nullptr) {
+        constructor_data->plan = new CallPlan(native_constructor.get());
+    }
+    Local<External> constructor_data_extern = Nan::New<External>((void *)constructor_data);
+    Local<FunctionTemplate> object_template = Nan::New<FunctionTemplate>(GIRStruct::constructor,
+                                                                         constructor_data_extern);
+    ObjectFunctionTemplate *oft = new ObjectFunctionTemplate();
+    oft->info = info; // ref'd above
+    oft->object_template = PersistentFunctionTemplate(object_template);
+    oft->type = g_registered_type_info_get_g_type(info);
+    oft->type_name = name;
+    oft->namespace_ = (char *)namespace_;
+    TemplateRegistry::insert(oft);
 
     object_template->SetClassName(Nan::New(name).ToLocalChecked());
 
@@ -79,12 +96,10 @@ Local<Function> GIRStruct::prepare(GIStructInfo *info) {
     v8::Local<v8::ObjectTemplate> object_instance_template = object_template->InstanceTemplate();
     object_instance_template->SetInternalFieldCount(1);
 
-    SetNamedPropertyHandler(object_instance_template,
-                            GIRStruct::property_get_handler,
-                            GIRStruct::property_set_handler,
-                            GIRStruct::property_query_handler);
-
+    GIRStruct::set_custom_methods(object_template, struct_info_extern);
     GIRStruct::register_methods(info, namespace_, object_template);
+    // fields are defined after methods so a field wins if their names clash
+    GIRStruct::register_fields(info, object_template);
 
     return object_template->GetFunction();
 }
@@ -104,9 +119,9 @@ void GIRStruct::register_methods(GIStructInfo *info, const char *namespace_, Han
         } else {
             // TODO: refactor GIRFunction::CreateMethod() to support more than GIRObject so
             // we can reuse that logic in here and keep is DRY!
-            Local<External> function_info_extern = Nan::New<External>((void *)g_base_info_ref(func));
+            Local<External> call_plan_extern = Nan::New<External>((void *)new CallPlan(func));
             Local<FunctionTemplate> method_template = Nan::New<FunctionTemplate>(GIRStruct::call_method,
-                                                                                 function_info_extern);
+                                                                                 call_plan_extern);
             object_template->PrototypeTemplate()->Set(function_name, method_template);
         }
         g_base_info_unref(func);
@@ -140,18 +155,17 @@ GIRInfoUniquePtr GIRStruct::find_native_constructor(GIStructInfo *struct_info) {
 }
 
 NAN_METHOD(GIRStruct::constructor) {
-    Local<External> struct_info_extern = Local<External>::Cast(info.Data());
-    GIStructInfo *struct_info = (GIStructInfo *)struct_info_extern->Value();
-    auto name = g_base_info_get_name(struct_info);
+    Local<External> constructor_data_extern = Local<External>::Cast(info.Data());
+    StructConstructorData *constructor_data = (StructConstructorData *)constructor_data_extern->Value();
+    GIStructInfo *struct_info = constructor_data->struct_info;
     GIRStruct *obj = new GIRStruct();
-    obj->struct_info = GIRInfoUniquePtr(struct_info);
+    obj->struct_info = GIRInfoUniquePtr(g_base_info_ref(struct_info)); // the wrapper releases it's own reference
 
-    GIRInfoUniquePtr func = GIRStruct::find_native_constructor(struct_info);
-    if (func != nullptr) {
+    if (constructor_data->plan != nullptr) {
         try {
-            Args args = Args(func.get());
+            Args args(*constructor_data->plan);
             args.load_js_arguments(info);
-            GIArgument result = GIRFunction::call_native(func.get(), args);
+            GIArgument result = GIRFunction::call_native(*constructor_data->plan, args);
             obj->boxed_c_structure = result.v_pointer;
         } catch (exception &error) {
             Nan::ThrowError(error.what());
@@ -181,86 +195,333 @@ NAN_METHOD(GIRStruct::constructor) {
 }
 
 NAN_METHOD(GIRStruct::call_method) {
-    Local<External> function_info_extern = Local<External>::Cast(info.Data());
-    GIFunctionInfo *function_info = (GIFunctionInfo *)function_info_extern->Value();
+    Local<External> call_plan_extern = Local<External>::Cast(info.Data());
+    CallPlan *plan = (CallPlan *)call_plan_extern->Value();
     GIRStruct *that = Nan::ObjectWrap::Unwrap<GIRStruct>(info.This()->ToObject());
-    Local<Value> result = GIRFunction::call((GObject *)that->boxed_c_structure, function_info, info);
+    Local<Value> result = GIRFunction::call((GObject *)that->boxed_c_structure, *plan, info);
     info.GetReturnValue().Set(result);
 }
 
-NAN_PROPERTY_GETTER(GIRStruct::property_get_handler) {
-    GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(info.This());
-    auto field_info = GIRInfoUniquePtr(
-        g_struct_info_find_field(gir_struct->struct_info.get(), *String::Utf8Value(property)));
+/**
+ * defines an accessor on the struct's prototype for each of it's fields
+ */
+void GIRStruct::register_fields(GIStructInfo *info, Local<FunctionTemplate> object_template) {
+    Local<ObjectTemplate> prototype_template = object_template->PrototypeTemplate();
+    int number_of_fields = g_struct_info_get_n_fields(info);
+    for (int i = 0; i < number_of_fields; i++) {
+        // the accessor's data lives for as long as the struct's class
+        FieldAccessor *accessor = new FieldAccessor();
+        GIRStruct::load_field_accessor(*accessor, g_struct_info_get_field(info, i));
+        Nan::SetAccessor(prototype_template,
+                         Nan::New(g_base_info_get_name(accessor->field_info.get())).ToLocalChecked(),
+                         GIRStruct::field_getter,
+                         GIRStruct::field_setter,
+                         Nan::New<External>((void *)accessor));
+    }
+}
+
+/**
+ * takes ownership of field_info
+ */
+void GIRStruct::load_field_accessor(FieldAccessor &accessor, GIFieldInfo *field_info) {
+    accessor.field_info = GIRInfoUniquePtr(field_info);
+    accessor.type_info = GIRInfoUniquePtr(g_field_info_get_type(field_info));
+    accessor.type_tag = g_type_info_get_tag(accessor.type_info.get());
+    accessor.offset = g_field_info_get_offset(field_info);
+    accessor.readable = g_field_info_get_flags(field_info) & GI_FIELD_IS_READABLE;
+    accessor.writable = g_field_info_get_flags(field_info) & GI_FIELD_IS_WRITABLE;
+
+    // numbers and booleans that are stored in the struct itself (not behind a
+    // pointer and not a bitfield) can be loaded and stored directly.
+    if (!g_type_info_is_pointer(accessor.type_info.get()) && g_field_info_get_size(field_info) == 0) {
+        switch (accessor.type_tag) {
+            case GI_TYPE_TAG_INT8:
+            case GI_TYPE_TAG_UINT8:
+                accessor.direct_size = 1;
+                break;
+            case GI_TYPE_TAG_INT16:
+            case GI_TYPE_TAG_UINT16:
+                accessor.direct_size = 2;
+                break;
+            case GI_TYPE_TAG_BOOLEAN:
+            case GI_TYPE_TAG_INT32:
+            case GI_TYPE_TAG_UINT32:
+            case GI_TYPE_TAG_FLOAT:
+                accessor.direct_size = 4;
+                break;
+            case GI_TYPE_TAG_INT64:
+            case GI_TYPE_TAG_UINT64:
+            case GI_TYPE_TAG_DOUBLE:
+                accessor.direct_size = 8;
+                break;
+            default:
+                break;
+        }
+    }
+    accessor.is_direct = accessor.direct_size > 0;
+}
 
-    // if the field doesn't exist on the native object then just return
-    // whatever is set for that property on the JS object
-    if (field_info == nullptr) {
-        info.GetReturnValue().Set(info.This()->GetPrototype()->ToObject()->Get(property));
+/**
+ * reads a direct field (see load_field_accessor) from the struct's memory
+ */
+Local<Value> GIRStruct::read_direct_field(FieldAccessor *accessor, gpointer c_structure) {
+    gpointer field = G_STRUCT_MEMBER_P(c_structure, accessor->offset);
+    switch (accessor->type_tag) {
+        case GI_TYPE_TAG_BOOLEAN:
+            return Nan::New<Boolean>(*(gboolean *)field);
+        case GI_TYPE_TAG_INT8:
+            return Nan::New(*(gint8 *)field);
+        case GI_TYPE_TAG_UINT8:
+            return Nan::New(*(guint8 *)field);
+        case GI_TYPE_TAG_INT16:
+            return Nan::New(*(gint16 *)field);
+        case GI_TYPE_TAG_UINT16:
+            return Nan::New(*(guint16 *)field);
+        case GI_TYPE_TAG_INT32:
+            return Nan::New(*(gint32 *)field);
+        case GI_TYPE_TAG_UINT32:
+            return Nan::New(*(guint32 *)field);
+        case GI_TYPE_TAG_INT64:
+            return Int64::from_int64(*(gint64 *)field);
+        case GI_TYPE_TAG_UINT64:
+            return Int64::from_uint64(*(guint64 *)field);
+        case GI_TYPE_TAG_FLOAT:
+            return Nan::New(*(gfloat *)field);
+        case GI_TYPE_TAG_DOUBLE:
+            return Nan::New(*(gdouble *)field);
+        default:
+            return Nan::Undefined();
+    }
+}
+
+/**
+ * writes a direct field (see load_field_accessor) into the struct's memory
+ */
+void GIRStruct::write_direct_field(FieldAccessor *accessor, gpointer c_structure, Local<Value> value) {
+    gpointer field = G_STRUCT_MEMBER_P(c_structure, accessor->offset);
+    switch (accessor->type_tag) {
+        case GI_TYPE_TAG_BOOLEAN:
+            *(gboolean *)field = value->BooleanValue();
+            break;
+        case GI_TYPE_TAG_INT8:
+            *(gint8 *)field = value->Int32Value();
+            break;
+        case GI_TYPE_TAG_UINT8:
+            *(guint8 *)field = value->Uint32Value();
+            break;
+        case GI_TYPE_TAG_INT16:
+            *(gint16 *)field = value->Int32Value();
+            break;
+        case GI_TYPE_TAG_UINT16:
+            *(guint16 *)field = value->Uint32Value();
+            break;
+        case GI_TYPE_TAG_INT32:
+            *(gint32 *)field = value->Int32Value();
+            break;
+        case GI_TYPE_TAG_UINT32:
+            *(guint32 *)field = value->Uint32Value();
+            break;
+        case GI_TYPE_TAG_INT64:
+            *(gint64 *)field = Int64::to_int64(value);
+            break;
+        case GI_TYPE_TAG_UINT64:
+            *(guint64 *)field = Int64::to_uint64(value);
+            break;
+        case GI_TYPE_TAG_FLOAT:
+            *(gfloat *)field = value->NumberValue();
+            break;
+        case GI_TYPE_TAG_DOUBLE:
+            *(gdouble *)field = value->NumberValue();
+            break;
+        default:
+            break;
+    }
+}
+
+void GIRStruct::set_custom_methods(Local<FunctionTemplate> object_template, Local<External> struct_info_extern) {
+    // these are set before the struct's native methods so a native method
+    // with the same name takes precedence.
+
+    // Add the 'asArrayBuffer' method to the prototype.
+    // This gives JS zero-copy access to the struct's memory.
+    Nan::SetPrototypeMethod(object_template, "asArrayBuffer", GIRStruct::as_array_buffer);
+
+    // Add the static 'getLayout' method to the class.
+    // This describes where each field is in the struct's memory.
+    object_template->Set(Nan::New("getLayout").ToLocalChecked(),
+                         Nan::New<FunctionTemplate>(GIRStruct::get_layout, struct_info_extern));
+}
+
+/**
+ * returns the name of the DataView method suffix (e.g. "Int32" for
+ * getInt32/setInt32) used to access a direct field of the given type.
+ */
+const char *GIRStruct::data_view_type(GITypeTag type_tag) {
+    switch (type_tag) {
+        case GI_TYPE_TAG_BOOLEAN: // a gboolean is a gint
+        case GI_TYPE_TAG_INT32:
+            return "Int32";
+        case GI_TYPE_TAG_INT8:
+            return "Int8";
+        case GI_TYPE_TAG_UINT8:
+            return "Uint8";
+        case GI_TYPE_TAG_INT16:
+            return "Int16";
+        case GI_TYPE_TAG_UINT16:
+            return "Uint16";
+        case GI_TYPE_TAG_UINT32:
+            return "Uint32";
+        case GI_TYPE_TAG_INT64:
+            return "BigInt64";
+        case GI_TYPE_TAG_UINT64:
+            return "BigUint64";
+        case GI_TYPE_TAG_FLOAT:
+            return "Float32";
+        case GI_TYPE_TAG_DOUBLE:
+            return "Float64";
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * struct.asArrayBuffer() returns an ArrayBuffer over the struct's memory,
+ * without copying it. Writes through the buffer change the struct. The
+ * buffer keeps the struct alive.
+ * The buffer is created once per struct and every call returns it, there
+ * must only ever be one ArrayBuffer over the same native memory.
+ */
+NAN_METHOD(GIRStruct::as_array_buffer) {
+    GIRStruct *that = Nan::ObjectWrap::Unwrap<GIRStruct>(info.This());
+    if (that->boxed_c_structure == nullptr) {
+        Nan::ThrowError("struct has no native memory");
+        return;
+    }
+
+    Local<String> buffer_key = Nan::New("node-gir:array-buffer").ToLocalChecked();
+    Local<Value> cached_buffer = Nan::GetPrivate(info.This(), buffer_key).ToLocalChecked();
+    if (cached_buffer->IsArrayBuffer()) {
+        info.GetReturnValue().Set(cached_buffer);
+        return;
+    }
+
+    gsize size = g_struct_info_get_size(that->struct_info.get());
+    Local<ArrayBuffer> buffer = ArrayBuffer::New(info.GetIsolate(), that->boxed_c_structure, size);
+    Nan::SetPrivate(buffer, Nan::New("node-gir:struct").ToLocalChecked(), info.This());
+    Nan::SetPrivate(info.This(), buffer_key, buffer);
+    info.GetReturnValue().Set(buffer);
+}
+
+/**
+ * StructClass.getLayout() returns { size, fields } where fields maps each
+ * number or boolean field that's stored inline in the struct to
+ * { offset, size, type }. type is the DataView method suffix for reading the
+ * field, booleans are gbooleans so they're "Int32". Values are in the host's
+ * byte order.
+ */
+NAN_METHOD(GIRStruct::get_layout) {
+    GIStructInfo *struct_info = (GIStructInfo *)Local<External>::Cast(info.Data())->Value();
+    Local<Object> layout = Nan::New<Object>();
+    Local<Object> fields = Nan::New<Object>();
+    Nan::Set(layout, Nan::New("size").ToLocalChecked(), Nan::New<Number>(g_struct_info_get_size(struct_info)));
+    Nan::Set(layout, Nan::New("fields").ToLocalChecked(), fields);
+
+    int number_of_fields = g_struct_info_get_n_fields(struct_info);
+    for (int i = 0; i < number_of_fields; i++) {
+        FieldAccessor accessor;
+        GIRStruct::load_field_accessor(accessor, g_struct_info_get_field(struct_info, i));
+        if (!accessor.is_direct) {
+            continue;
+        }
+        Local<Object> field = Nan::New<Object>();
+        Nan::Set(field, Nan::New("offset").ToLocalChecked(), Nan::New(accessor.offset));
+        Nan::Set(field,
+                 Nan::New("size").ToLocalChecked(),
+                 Nan::New<Number>(accessor.direct_size));
+        Nan::Set(field,
+                 Nan::New("type").ToLocalChecked(),
+                 Nan::New(GIRStruct::data_view_type(accessor.type_tag)).ToLocalChecked());
+        Nan::Set(fields, Nan::New(g_base_info_get_name(accessor.field_info.get())).ToLocalChecked(), field);
+    }
+    info.GetReturnValue().Set(layout);
+}
+
+NAN_GETTER(GIRStruct::field_getter) {
+    // the accessor can be read from the prototype itself, which has no struct
+    if (info.This()->InternalFieldCount() == 0) {
         return;
     }
+    GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(info.This());
+    FieldAccessor *accessor = (FieldAccessor *)Local<External>::Cast(info.Data())->Value();
+    GIFieldInfo *field_info = accessor->field_info.get();
 
     // throw a JS error if the field isn't readable
-    if (!(g_field_info_get_flags(field_info.get()) & GI_FIELD_IS_READABLE)) {
+    if (!accessor->readable) {
         stringstream message;
-        message << "property '" << g_base_info_get_name(field_info.get()) << "' is not readable";
+        message << "property '" << g_base_info_get_name(field_info) << "' is not readable";
         Nan::ThrowError(Nan::New(message.str()).ToLocalChecked());
         return;
     }
 
+    if (accessor->is_direct) {
+        info.GetReturnValue().Set(GIRStruct::read_direct_field(accessor, gir_struct->boxed_c_structure));
+        return;
+    }
+
     // otherwise we can get the native field's property and return it to JS
     GIArgument native_field_value;
-    bool successfully_retrieved = g_field_info_get_field(field_info.get(),
+    bool successfully_retrieved = g_field_info_get_field(field_info,
                                                          gir_struct->boxed_c_structure,
                                                          &native_field_value);
     if (!successfully_retrieved) {
         stringstream message;
-        message << "reading property '" << g_base_info_get_name(field_info.get()) << "' failed with an unknown error";
+        message << "reading property '" << g_base_info_get_name(field_info) << "' failed with an unknown error";
         Nan::ThrowError(Nan::New(message.str()).ToLocalChecked());
         return;
     }
 
     // converty the native value to a JS value
-    auto type_info = GIRInfoUniquePtr(g_field_info_get_type(field_info.get()));
-    Local<Value> res = Args::from_g_type(&native_field_value, type_info.get(), 0);
+    Local<Value> res = Args::from_g_type(&native_field_value, accessor->type_info.get(), -1);
     info.GetReturnValue().Set(res);
     return;
 }
 
-NAN_PROPERTY_SETTER(GIRStruct::property_set_handler) {
-    GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(info.This());
-    String::Utf8Value property_name(property);
-    auto field_info = GIRInfoUniquePtr(g_struct_info_find_field(gir_struct->struct_info.get(), *property_name));
-
-    // if the native field doesn't exist then just set on the regular JS object
-    if (field_info == nullptr) {
-        info.This()->GetPrototype()->ToObject()->Set(property, value);
+NAN_SETTER(GIRStruct::field_setter) {
+    if (info.This()->InternalFieldCount() == 0) {
         return;
     }
+    GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(info.This());
+    FieldAccessor *accessor = (FieldAccessor *)Local<External>::Cast(info.Data())->Value();
+    GIFieldInfo *field_info = accessor->field_info.get();
 
     // throw a JS error if the field isn't writable
-    if (!(g_field_info_get_flags(field_info.get()) & GI_FIELD_IS_WRITABLE)) {
+    if (!accessor->writable) {
         stringstream message;
-        message << "property '" << g_base_info_get_name(field_info.get()) << "' is not writable";
+        message << "property '" << g_base_info_get_name(field_info) << "' is not writable";
         Nan::ThrowError(Nan::New(message.str()).ToLocalChecked());
         return;
     }
 
-    // otherwise set the native field
-    auto type_info = GIRInfoUniquePtr(g_field_info_get_type(field_info.get()));
-    GIArgument native_value = Args::type_to_g_type(*type_info, value);
-    bool successfully_set = g_field_info_set_field(field_info.get(), gir_struct->boxed_c_structure, &native_value);
+    GIArgument native_value;
+    try {
+        if (accessor->is_direct) {
+            GIRStruct::write_direct_field(accessor, gir_struct->boxed_c_structure, value);
+            return;
+        }
+        // otherwise set the native field
+        native_value = Args::type_to_g_type(*accessor->type_info, value);
+    } catch (exception &error) {
+        Nan::ThrowError(error.what());
+        return;
+    }
+
+    bool successfully_set = g_field_info_set_field(field_info, gir_struct->boxed_c_structure, &native_value);
     if (!successfully_set) {
         stringstream message;
-        message << "setting property '" << g_base_info_get_name(field_info.get()) << "' failed with an unknown error";
+        message << "setting property '" << g_base_info_get_name(field_info) << "' failed with an unknown error";
         Nan::ThrowError(Nan::New(message.str()).ToLocalChecked());
         return;
     }
 }
 
-NAN_PROPERTY_QUERY(GIRStruct::property_query_handler) {
-    // FIXME: I have no idea what this is suppose to do
-    info.GetReturnValue().Set(Nan::New(0));
-}
-
 } // namespace gir
@@ -5,18 +5,41 @@
 #include <nan.h>
 #include <v8.h>
 #include <vector>
-#include <internal/PersistentObjectStore.h>
+#include <internal/TemplateRegistry.h>
+#include "call_plan.h"
 #include "util.h"
 
 namespace gir {
 
 using namespace v8;
 
-// Use the managed trait as this is for storing structs managed by Gtk main loop
-using PersistentFunctionTemplate = Nan::Persistent<FunctionTemplate, CopyablePersistentTraits<FunctionTemplate>>;
-
 class GIRStruct;
 
+/**
+ * The data for a struct field's accessor, built once per field. Fields
+ * holding a number or boolean are read and written directly at their offset
+ * in the struct, anything else goes through g_field_info_get_field/set_field.
+ */
+struct FieldAccessor {
+    GIRInfoUniquePtr field_info;
+    GIRInfoUniquePtr type_info;
+    GITypeTag type_tag;
+    int offset;
+    bool readable;
+    bool writable;
+    bool is_direct;
+    gsize direct_size = 0; // the size in bytes of a direct field
+};
+
+/**
+ * The data of a struct's JS constructor. The plan for the struct's native
+ * constructor is built once, with the struct's template.
+ */
+struct StructConstructorData {
+    GIStructInfo *struct_info;
+    CallPlan *plan; // nullptr if the struct doesn't have a native constructor
+};
+
 class GIRStruct : public Nan::ObjectWrap {
 public:
     gpointer get_native_ptr();
@@ -25,8 +48,6 @@ public:
     static Local<Value> from_existing(gpointer boxed_c_structure, GIStructInfo *info);
 
 private:
-    static PersistentObjectStore<GType, PersistentFunctionTemplate> prepared_js_classes;
-
     gpointer boxed_c_structure = nullptr;
     GIRInfoUniquePtr struct_info = nullptr;
 
@@ -38,11 +59,18 @@ private:
 
     static GIRInfoUniquePtr find_native_constructor(GIStructInfo *struct_info);
     static void register_methods(GIStructInfo *info, const char *namespace_, Local<FunctionTemplate> object_template);
+    static void set_custom_methods(Local<FunctionTemplate> object_template, Local<External> struct_info_extern);
+    static const char *data_view_type(GITypeTag type_tag);
+    static NAN_METHOD(as_array_buffer);
+    static NAN_METHOD(get_layout);
     static NAN_METHOD(constructor);
     static NAN_METHOD(call_method);
-    static NAN_PROPERTY_GETTER(property_get_handler);
-    static NAN_PROPERTY_SETTER(property_set_handler);
-    static NAN_PROPERTY_QUERY(property_query_handler);
+    static void register_fields(GIStructInfo *info, Local<FunctionTemplate> object_template);
+    static void load_field_accessor(FieldAccessor &accessor, GIFieldInfo *field_info);
+    static Local<Value> read_direct_field(FieldAccessor *accessor, gpointer c_structure);
+    static void write_direct_field(FieldAccessor *accessor, gpointer c_structure, Local<Value> value);
+    static NAN_GETTER(field_getter);
+    static NAN_SETTER(field_setter);
 
     GIRStruct() = default;
     ~GIRStruct();
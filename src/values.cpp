@@ -6,6 +6,7 @@
 #include <sstream>
 #include "arguments.h"
 #include "exceptions.h"
+#include "int64.h"
 #include "types/object.h"
 #include "types/struct.h"
 
@@ -13,211 +14,380 @@ using namespace v8;
 
 namespace gir {
 
-Local<Value> GIRValue::from_g_value(const GValue *gvalue, GITypeInfo *type_info) {
-    switch (G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(gvalue))) {
-        case G_TYPE_CHAR: {
-            char str[2];
-            str[0] = g_value_get_schar(gvalue);
-            str[1] = '\0';
-            return Nan::New(str).ToLocalChecked();
-        } break;
-
-        case G_TYPE_UCHAR: {
-            char str[2];
-            str[0] = g_value_get_uchar(gvalue);
-            str[1] = '\0';
-            return Nan::New(str).ToLocalChecked();
-        } break;
+// the converters for each fundamental type. The GValue's type has already been
+// checked (and, for to_g_value, initialized) by the time these are called.
 
-        case G_TYPE_BOOLEAN:
-            return Nan::New<Boolean>(g_value_get_boolean(gvalue));
+static Local<Value> char_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    char str[2] = {(char)g_value_get_schar(gvalue), '\0'};
+    return Nan::New(str).ToLocalChecked();
+}
 
-        case G_TYPE_INT:
-            return Nan::New(g_value_get_int(gvalue));
+static void char_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    String::Utf8Value value(js_value->ToString());
+    g_value_set_schar(gvalue, (*value)[0]);
+}
 
-        case G_TYPE_UINT:
-            return Nan::New(g_value_get_uint(gvalue));
+static Local<Value> uchar_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    char str[2] = {(char)g_value_get_uchar(gvalue), '\0'};
+    return Nan::New(str).ToLocalChecked();
+}
 
-        case G_TYPE_LONG:
-            return Nan::New<Number>(g_value_get_long(gvalue));
+static void uchar_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    String::Utf8Value value(js_value->ToString());
+    g_value_set_uchar(gvalue, (*value)[0]);
+}
 
-        case G_TYPE_ULONG:
-            return Nan::New<Number>(g_value_get_ulong(gvalue));
+static Local<Value> boolean_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Nan::New<Boolean>(g_value_get_boolean(gvalue));
+}
 
-        case G_TYPE_INT64:
-            return Nan::New<Number>(g_value_get_int64(gvalue));
+static void boolean_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_boolean(gvalue, js_value->BooleanValue());
+}
 
-        case G_TYPE_UINT64:
-            return Nan::New<Number>(g_value_get_uint64(gvalue));
+static Local<Value> int_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Nan::New(g_value_get_int(gvalue));
+}
 
-        case G_TYPE_ENUM:
-            return Nan::New(g_value_get_enum(gvalue));
+static void int_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_int(gvalue, js_value->Int32Value());
+}
 
-        case G_TYPE_FLAGS:
-            return Nan::New(g_value_get_flags(gvalue));
+static Local<Value> uint_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Nan::New(g_value_get_uint(gvalue));
+}
 
-        case G_TYPE_FLOAT:
-            return Nan::New(g_value_get_float(gvalue));
+static void uint_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_uint(gvalue, js_value->Uint32Value());
+}
 
-        case G_TYPE_DOUBLE:
-            return Nan::New(g_value_get_double(gvalue));
+static Local<Value> long_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Int64::from_int64(g_value_get_long(gvalue));
+}
 
-        case G_TYPE_STRING:
-            return Nan::New(g_value_get_string(gvalue)).ToLocalChecked();
+static void long_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_long(gvalue, Int64::to_int64(js_value));
+}
 
-        case G_TYPE_BOXED:
-            if (G_VALUE_TYPE(gvalue) == G_TYPE_ARRAY) {
-                throw UnsupportedGValueType("GIRValue - GValueArray conversion not supported");
-            } else {
-                GIBaseInfo *boxed_info = g_irepository_find_by_gtype(g_irepository_get_default(), G_VALUE_TYPE(gvalue));
-                return GIRStruct::from_existing((GIRStruct *)g_value_get_boxed(gvalue), boxed_info);
-            }
-            break;
+static Local<Value> ulong_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Int64::from_uint64(g_value_get_ulong(gvalue));
+}
 
-        case G_TYPE_OBJECT: {
-            GIBaseInfo *object_info = g_irepository_find_by_gtype(g_irepository_get_default(), G_VALUE_TYPE(gvalue));
-            return GIRObject::from_existing(G_OBJECT(g_value_get_object(gvalue)), object_info);
-        } break;
+static void ulong_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_ulong(gvalue, Int64::to_uint64(js_value));
+}
 
-        default:
-            throw UnsupportedGValueType("GIRValue - conversion of input type not supported");
+static Local<Value> int64_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Int64::from_int64(g_value_get_int64(gvalue));
+}
+
+static void int64_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_int64(gvalue, Int64::to_int64(js_value));
+}
+
+static Local<Value> uint64_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Int64::from_uint64(g_value_get_uint64(gvalue));
+}
+
+static void uint64_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_uint64(gvalue, Int64::to_uint64(js_value));
+}
+
+static Local<Value> enum_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Nan::New(g_value_get_enum(gvalue));
+}
+
+static void enum_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_enum(gvalue, js_value->IntegerValue());
+}
+
+static Local<Value> flags_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Nan::New(g_value_get_flags(gvalue));
+}
+
+static void flags_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_flags(gvalue, js_value->IntegerValue());
+}
+
+static Local<Value> float_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Nan::New(g_value_get_float(gvalue));
+}
+
+static void float_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_float(gvalue, js_value->NumberValue());
+}
+
+static Local<Value> double_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return Nan::New(g_value_get_double(gvalue));
+}
+
+static void double_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_double(gvalue, js_value->NumberValue());
+}
+
+static Local<Value> string_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    const char *string = g_value_get_string(gvalue);
+    if (string == nullptr) {
+        return Nan::Null();
     }
+    return Nan::New(string).ToLocalChecked();
 }
 
-// TODO: refactor to follow the style that Args::ToGType does
-// i.e. return a GValue and throw std::exceptions on failure
-GValue GIRValue::to_g_value(Local<Value> js_value, GType g_type) {
-    GValue g_value = G_VALUE_INIT;
+static void string_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    String::Utf8Value value(js_value->ToString());
+    g_value_set_string(gvalue, *value);
+}
 
-    if (g_type == G_TYPE_INVALID || g_type == 0) {
-        g_type = GIRValue::guess_type(js_value);
+static Local<Value> boxed_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    gpointer boxed = g_value_get_boxed(gvalue);
+    if (boxed == nullptr) {
+        return Nan::Null();
     }
+    if (converter.info == nullptr) {
+        // the typelib with the boxed type hasn't been loaded (yet)
+        stringstream message;
+        message << "Boxed type '" << g_type_name(G_VALUE_TYPE(gvalue)) << "' isn't in a loaded typelib";
+        throw UnsupportedGValueType(message.str());
+    }
+    return GIRStruct::from_existing(boxed, converter.info);
+}
 
-    if (g_type == G_TYPE_INVALID) {
-        throw JSValueError("Could not guess the native value type from JS");
+static void boxed_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    // we expect the js value to be a GIRStruct
+    // FIXME: error handling for invalid unwraps
+    GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(js_value->ToObject());
+    g_value_set_boxed(gvalue, gir_struct->get_native_ptr());
+}
+
+static Local<Value> object_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    return GIRObject::from_existing(G_OBJECT(g_value_get_object(gvalue)), converter.info);
+}
+
+static void object_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    g_value_set_object(gvalue, Nan::ObjectWrap::Unwrap<GIRObject>(js_value->ToObject())->get_gobject());
+}
+
+static Local<Value> unsupported_to_js(const GValue *gvalue, const GValueConverter &converter) {
+    if (G_VALUE_TYPE(gvalue) == G_TYPE_ARRAY) {
+        throw UnsupportedGValueType("GIRValue - GValueArray conversion not supported");
     }
+    throw UnsupportedGValueType("GIRValue - conversion of input type not supported");
+}
 
-    g_value_init(&g_value, g_type);
+static void unsupported_from_js(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter) {
+    switch (G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(gvalue))) {
+        case G_TYPE_PARAM:
+        case G_TYPE_POINTER: {
+            stringstream message;
+            message << "Native value type '" << g_type_name(G_VALUE_TYPE(gvalue)) << "' is not yet supported";
+            throw UnsupportedGValueType(message.str());
+        }
+        default:
+            throw JSValueError("Failed to convert value");
+    }
+}
 
-    switch (G_TYPE_FUNDAMENTAL(g_type)) {
-        case G_TYPE_INTERFACE:
-        case G_TYPE_OBJECT:
-            g_value_set_object(&g_value, Nan::ObjectWrap::Unwrap<GIRObject>(js_value->ToObject())->get_gobject());
-            break;
+/**
+ * the converters by GType. Entries are never removed so references to them
+ * (e.g. in SignalPlans) stay valid.
+ */
+static std::unordered_map<GType, GValueConverter> converters;
+
+/**
+ * returns the converter for GValues of the given type, resolving (and caching)
+ * it the first time the type is seen.
+ */
+const GValueConverter &GIRValue::get_converter(GType g_type) {
+    auto found = converters.find(g_type);
+    if (found != converters.end()) {
+        return found->second;
+    }
+    return converters.emplace(g_type, GIRValue::build_converter(g_type)).first->second;
+}
 
-        case G_TYPE_CHAR: {
-            String::Utf8Value value(js_value->ToString());
-            g_value_set_schar(&g_value, (*value)[0]);
-        } break;
+/**
+ * looks up the info of boxed and object converters again after a namespace is
+ * loaded. A converter that was built before the typelib with it's type was
+ * loaded has no info (boxed types) or a parent's info (object types).
+ */
+void GIRValue::refresh_converters() {
+    for (auto &entry : converters) {
+        GValueConverter &converter = entry.second;
+        if (converter.to_js != boxed_to_js && converter.to_js != object_to_js) {
+            continue;
+        }
+        if (converter.info != nullptr && g_registered_type_info_get_g_type(converter.info) == entry.first) {
+            continue;
+        }
+        GIBaseInfo *info = GIRValue::find_info(entry.first, converter.to_js == object_to_js);
+        if (converter.info != nullptr) {
+            g_base_info_unref(converter.info);
+        }
+        converter.info = info;
+    }
+}
+
+/**
+ * returns the typelib's info for a boxed or object type. Object types that
+ * aren't in a typelib (such as private subclasses) get their closest parent's
+ * info when use_parent is true.
+ */
+GIBaseInfo *GIRValue::find_info(GType g_type, bool use_parent) {
+    GIBaseInfo *info = g_irepository_find_by_gtype(g_irepository_get_default(), g_type);
+    if (use_parent) {
+        for (GType type = g_type_parent(g_type); type != 0 && info == nullptr; type = g_type_parent(type)) {
+            info = g_irepository_find_by_gtype(g_irepository_get_default(), type);
+        }
+    }
+    return info;
+}
 
-        case G_TYPE_UCHAR: {
-            String::Utf8Value value(js_value->ToString());
-            g_value_set_uchar(&g_value, (*value)[0]);
-        } break;
+GValueConverter GIRValue::build_converter(GType g_type) {
+    GValueConverter converter = {unsupported_to_js, unsupported_from_js, nullptr};
 
+    switch (G_TYPE_FUNDAMENTAL(g_type)) {
+        case G_TYPE_CHAR:
+            converter.to_js = char_to_js;
+            converter.from_js = char_from_js;
+            break;
+        case G_TYPE_UCHAR:
+            converter.to_js = uchar_to_js;
+            converter.from_js = uchar_from_js;
+            break;
         case G_TYPE_BOOLEAN:
-            g_value_set_boolean(&g_value, js_value->BooleanValue());
+            converter.to_js = boolean_to_js;
+            converter.from_js = boolean_from_js;
             break;
-
         case G_TYPE_INT:
-            g_value_set_int(&g_value, js_value->Int32Value());
+            converter.to_js = int_to_js;
+            converter.from_js = int_from_js;
             break;
-
         case G_TYPE_UINT:
-            g_value_set_uint(&g_value, js_value->Uint32Value());
+            converter.to_js = uint_to_js;
+            converter.from_js = uint_from_js;
             break;
-
         case G_TYPE_LONG:
-            g_value_set_long(&g_value, js_value->NumberValue());
+            converter.to_js = long_to_js;
+            converter.from_js = long_from_js;
             break;
-
         case G_TYPE_ULONG:
-            g_value_set_ulong(&g_value, js_value->NumberValue());
+            converter.to_js = ulong_to_js;
+            converter.from_js = ulong_from_js;
             break;
-
         case G_TYPE_INT64:
-            g_value_set_int64(&g_value, js_value->IntegerValue());
+            converter.to_js = int64_to_js;
+            converter.from_js = int64_from_js;
             break;
-
         case G_TYPE_UINT64:
-            g_value_set_uint64(&g_value, js_value->IntegerValue());
+            converter.to_js = uint64_to_js;
+            converter.from_js = uint64_from_js;
             break;
-
         case G_TYPE_ENUM:
-            g_value_set_enum(&g_value, js_value->IntegerValue());
+            converter.to_js = enum_to_js;
+            converter.from_js = enum_from_js;
             break;
-
         case G_TYPE_FLAGS:
-            g_value_set_flags(&g_value, js_value->IntegerValue());
+            converter.to_js = flags_to_js;
+            converter.from_js = flags_from_js;
             break;
-
         case G_TYPE_FLOAT:
-            g_value_set_float(&g_value, js_value->NumberValue());
+            converter.to_js = float_to_js;
+            converter.from_js = float_from_js;
             break;
-
         case G_TYPE_DOUBLE:
-            g_value_set_double(&g_value, js_value->NumberValue());
+            converter.to_js = double_to_js;
+            converter.from_js = double_from_js;
+            break;
+        case G_TYPE_STRING:
+            converter.to_js = string_to_js;
+            converter.from_js = string_from_js;
             break;
-
-        case G_TYPE_STRING: {
-            String::Utf8Value value(js_value->ToString());
-            g_value_set_string(&g_value, *value);
-        } break;
-
         case G_TYPE_BOXED:
-            if (g_type_is_a(g_type, G_TYPE_VALUE)) {
-                // we have a special case for GValue itself. If we need to convert a JS
-                // value into a GValue we must guess the native type. The easiest
-                // way to do that is to just call this same function (to_g_value).
-                // GIRValue::guess_type can't return G_TYPE_VALUE so we're save
-                // from infinite recursion.
-                return GIRValue::to_g_value(js_value, GIRValue::guess_type(js_value));
-            } else {
-                // otherwise we expect the js value to be a GIRStruct
-                // FIXME: error handling for invalid unwraps
-                GIRStruct *gir_struct = Nan::ObjectWrap::Unwrap<GIRStruct>(js_value->ToObject());
-                g_value_set_boxed(&g_value, gir_struct->get_native_ptr());
+            if (g_type != G_TYPE_ARRAY) {
+                converter.to_js = boxed_to_js;
+                converter.from_js = boxed_from_js;
+                converter.info = GIRValue::find_info(g_type, false);
             }
             break;
-
-        case G_TYPE_PARAM:
-        case G_TYPE_POINTER: {
-            stringstream message;
-            message << "Native value type '" << g_type_name(g_type) << "' is not yet supported";
-            throw UnsupportedGValueType(message.str());
-        } break;
-
+        case G_TYPE_INTERFACE:
+        case G_TYPE_OBJECT:
+            converter.to_js = object_to_js;
+            converter.from_js = object_from_js;
+            // types that aren't in a typelib (such as private subclasses) are
+            // converted as their closest parent that is.
+            converter.info = GIRValue::find_info(g_type, true);
+            break;
         default:
-            throw JSValueError("Failed to convert value");
             break;
     }
+    return converter;
+}
+
+Local<Value> GIRValue::from_g_value(const GValue *gvalue, GITypeInfo *type_info) {
+    const GValueConverter &converter = GIRValue::get_converter(G_VALUE_TYPE(gvalue));
+    return converter.to_js(gvalue, converter);
+}
+
+// TODO: refactor to follow the style that Args::ToGType does
+// i.e. return a GValue and throw std::exceptions on failure
+GValue GIRValue::to_g_value(Local<Value> js_value, GType g_type) {
+    GValue g_value = G_VALUE_INIT;
+
+    if (g_type == G_TYPE_INVALID || g_type == 0) {
+        g_type = GIRValue::guess_type(js_value);
+    }
+
+    if (g_type == G_TYPE_INVALID) {
+        throw JSValueError("Could not guess the native value type from JS");
+    }
+
+    // we have a special case for GValue itself. If we need to convert a JS
+    // value into a GValue we must guess the native type. GIRValue::guess_type
+    // can't return G_TYPE_VALUE so we're safe from infinite recursion.
+    if (g_type_is_a(g_type, G_TYPE_VALUE)) {
+        return GIRValue::to_g_value(js_value, GIRValue::guess_type(js_value));
+    }
+
+    const GValueConverter &converter = GIRValue::get_converter(g_type);
+    g_value_init(&g_value, g_type);
+    try {
+        converter.from_js(&g_value, js_value, converter);
+    } catch (exception &error) {
+        g_value_unset(&g_value);
+        throw;
+    }
     return g_value;
 }
 
 GType GIRValue::guess_type(Handle<Value> value) {
-    if (value->IsString()) {
-        return G_TYPE_STRING;
+    // numbers and strings are by far the most common values so they're checked first
+    if (value->IsNumber()) {
+        if (value->IsInt32()) {
+            return G_TYPE_INT;
+        }
+        if (value->IsUint32()) {
+            return G_TYPE_UINT;
+        }
+        return G_TYPE_DOUBLE;
     }
 
-    if (value->IsArray()) {
-        return G_TYPE_ARRAY;
+    if (value->IsString()) {
+        return G_TYPE_STRING;
     }
 
     if (value->IsBoolean()) {
         return G_TYPE_BOOLEAN;
     }
 
-    if (value->IsInt32()) {
-        return G_TYPE_INT;
-    }
-
-    if (value->IsUint32()) {
-        return G_TYPE_UINT;
+    if (value->IsArray()) {
+        return G_TYPE_ARRAY;
     }
 
-    if (value->IsNumber()) {
-        return G_TYPE_DOUBLE;
+#if NODE_GIR_HAVE_BIGINT
+    if (value->IsBigInt()) {
+        return G_TYPE_INT64;
     }
+#endif
 
     if (value->IsNull()) {
         return G_TYPE_POINTER;
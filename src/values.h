@@ -3,18 +3,43 @@
 #include <girepository.h>
 #include <glib.h>
 #include <v8.h>
+#include <unordered_map>
 
 namespace gir {
 
 using namespace v8;
 
+struct GValueConverter;
+
+using GValueToJS = Local<Value> (*)(const GValue *gvalue, const GValueConverter &converter);
+using GValueFromJS = void (*)(GValue *gvalue, Local<Value> js_value, const GValueConverter &converter);
+
+/**
+ * How to convert GValues of a particular GType to and from JS. Converters are
+ * resolved the first time a GType is seen and are then reused for every value
+ * of that type.
+ */
+struct GValueConverter {
+    GValueToJS to_js;
+    GValueFromJS from_js;
+    // the typelib's info for boxed and object types (or their closest parent
+    // that's in the typelib). It's nullptr for other types and for boxed types
+    // whose typelib isn't loaded yet (see GIRValue::refresh_converters).
+    // Converters live for as long as the process does so they own this reference.
+    GIBaseInfo *info;
+};
+
 class GIRValue {
 public:
     static GValue to_g_value(Local<Value> value, GType g_type);
     static Local<Value> from_g_value(const GValue *v, GITypeInfo *type_info);
+    static const GValueConverter &get_converter(GType g_type);
+    static void refresh_converters();
 
 private:
     static GType guess_type(Local<Value> value);
+    static GValueConverter build_converter(GType g_type);
+    static GIBaseInfo *find_info(GType g_type, bool use_parent);
 };
 
 } // namespace gir